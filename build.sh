@@ -3,7 +3,7 @@
 # Build and run the OpenGL terrain project
 
 echo "Building the project..."
-g++ -Iinclude $(find src -name '*.cpp') -lGL -lGLU -lGLEW -lglfw -o terrain
+g++ -Iinclude $(find src -name '*.cpp') -lGL -lGLU -lGLEW -lglfw -pthread -o terrain
 
 if [ $? -eq 0 ]; then
     echo "Build successful. Running the application..."
@@ -36,6 +36,7 @@ private:
     float m_MaxPitch;
     float m_Yaw;        // degrees
     float m_TargetYOffset;
+    float m_TerrainClearance = 0.3f; // minimum gap kept between the camera and the ground
 
     // Derived state
     glm::vec3 m_Position;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = normal, w = offset), extracted from a
+// combined projection * view matrix. Tests are conservative: a volume near a frustum corner
+// may be reported visible when it is not, but a visible one is never rejected.
+class Frustum {
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    // Axis-aligned box [lo, hi]
+    bool IntersectsBox(const glm::vec3& lo, const glm::vec3& hi) const;
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+private:
+    glm::vec4 m_Planes[6]; // left, right, bottom, top, near, far
+};
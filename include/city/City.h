@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 // Generate a simple city layout with houses, roads and street lights
@@ -7,6 +8,9 @@
 // areaRadius: approximate radius around origin to place houses
 #include <glm/vec2.hpp>
 
+// Seed of the generator's random sequence, which carries over between generateCity calls
+const uint64_t CITY_RNG_SEED = 123456;
+
 // generateCity: optionally accept a lake center so the caller (scene) can place the lake
 void generateCity(int nHouses = 30, float areaRadius = 40.0f, const glm::vec2 &lakeCenter = glm::vec2(0.0f,0.0f));
 
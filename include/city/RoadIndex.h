@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "../core/SpatialHash.h"
+#include "../objects.h"
+
+// A road centreline point found by RoadIndex: on segment pts[segment] .. pts[segment + 1]
+// of road (its position in getRoads())
+struct RoadHit {
+    bool found = false;
+    uint32_t road = 0;
+    uint32_t segment = 0;
+    float distance = 0.0f; // from the query point to the centreline
+    float halfWidth = 0.0f;
+    glm::vec2 point{ 0.0f };
+};
+
+// Spatial index over road segments for proximity queries. Each segment is listed in every
+// SpatialHash cell it passes through (not its whole bounding box, so long diagonal roads
+// stay cheap), and queries only measure the segments in the cells around the query point.
+// Queries are safe on several threads at once; adding roads is not.
+class RoadIndex {
+public:
+    explicit RoadIndex(float cellSize = 8.0f);
+
+    void Clear();
+    // Indexes the segments of road id (its position in the road list)
+    void AddRoad(uint32_t id, const Road& road);
+
+    // Closest centreline point within maxDistance of p; found is false if there is none
+    RoadHit Nearest(const glm::vec2& p, float maxDistance = 1e30f) const;
+    // Distance from p to the closest centreline, or maxDistance if none is closer
+    float Distance(const glm::vec2& p, float maxDistance = 1e30f) const;
+    // Appends the closest point of every segment whose centreline is within radius of p
+    void WithinRadius(const glm::vec2& p, float radius, std::vector<RoadHit>& out) const;
+    // Whether p is within clearance of a road surface (its centreline closer than
+    // halfWidth + clearance)
+    bool NearSurface(const glm::vec2& p, float clearance) const;
+
+    size_t SegmentCount() const { return m_Segments.size(); }
+
+private:
+    struct Segment {
+        glm::vec2 a, b;
+        uint32_t road, index;
+        float halfWidth;
+    };
+
+    RoadHit measure(uint32_t id, const glm::vec2& p) const;
+    // Segments overlapping the cells around [p - r, p + r], in a per-thread scratch list
+    const std::vector<uint32_t>& candidates(const glm::vec2& p, float r) const;
+
+    SpatialHash m_Grid;
+    std::vector<Segment> m_Segments;
+    glm::vec2 m_Min{ 0.0f }, m_Max{ 0.0f }; // bounds of every segment
+    float m_MaxHalfWidth = 0.0f;
+};
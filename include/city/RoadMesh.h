@@ -0,0 +1,62 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "../objects.h"
+
+// Coloured road vertex as uploaded to the GPU
+struct RoadVertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+static_assert(sizeof(RoadVertex) == 16, "road vertex must stay 16 bytes");
+
+// One road in world space: asphalt, sidewalks, centre markings and intersection caps as
+// triangles, curbs as line pairs
+struct RoadGeometry {
+    std::vector<RoadVertex> triangles;
+    std::vector<RoadVertex> lines;
+};
+
+// Builds a road's geometry from its centreline samples (already lifted onto the terrain)
+// and the asphalt / concrete fans of its intersection caps, alternating
+void bakeRoadGeometry(const Road& road, const std::vector<glm::vec3>& samples,
+                      const std::vector<std::vector<glm::vec3>>& caps, float sidewalkWidth, RoadGeometry& out);
+
+// Every road's geometry in one GPU vertex buffer, each road's triangles and lines in a
+// contiguous range. Changing a road re-uploads the buffer on the next Draw; drawing any
+// subset of roads is two glMultiDrawArrays calls and allocates nothing once warmed up. GL
+// objects are released explicitly, as for TerrainMesh.
+class RoadMesh {
+public:
+    // Replaces the geometry of road index, growing the road list as needed
+    void SetRoad(size_t index, const RoadGeometry& geometry);
+    // Drops every road; the buffer is kept for reuse
+    void Clear();
+    // Draws the listed roads
+    void Draw(const std::vector<uint32_t>& roads);
+    void Release();
+
+    size_t GpuBytes() const { return m_Bytes; }
+
+private:
+    struct Range {
+        GLint first = 0;
+        GLsizei count = 0;
+    };
+
+    void upload();
+    void multiDraw(GLenum mode, const std::vector<Range>& ranges, const std::vector<uint32_t>& roads);
+
+    std::vector<RoadGeometry> m_Roads;
+    std::vector<Range> m_TriangleRanges;
+    std::vector<Range> m_LineRanges;
+    bool m_Dirty = false;
+    GLuint m_VBO = 0;
+    size_t m_Bytes = 0;
+    // Per-draw call lists, kept between frames
+    std::vector<GLint> m_First;
+    std::vector<GLsizei> m_Count;
+};
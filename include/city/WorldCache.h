@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk snapshot of a generated world: the terrain height grid plus the buildings, roads,
+// ponds, street lights, coins and trees placed on it. The file is named after a key the caller
+// hashes from every seed and parameter that went into generation (see core/Hash.h), so
+// any change to them simply misses the cache.
+//
+// Layout: WorldCacheHeader, then the height grid, roads, buildings, ponds, lights, coins
+// and trees, each as a count followed by plain records. The whole file is read with one call
+// and parsed in memory.
+
+// Restores the world stored for key in dir. Terrain features (mountains, base surface,
+// layout) must already be set as they were when it was saved; ponds and the city objects
+// are replaced. Prints the load time next to the original generation time. Returns false,
+// leaving the world untouched, if there is no valid entry.
+bool loadWorldCache(const char* dir, uint64_t key);
+
+// Saves the current world for key; generationMs is reported by later loads
+bool saveWorldCache(const char* dir, uint64_t key, double generationMs);
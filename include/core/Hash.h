@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Incremental 64-bit FNV-1a over raw bytes. Used to key on-disk caches by the parameters
+// (or content) they were generated from, so values must be fed in a fixed order and
+// layout; it is not meant to resist deliberate collisions.
+class Hasher {
+public:
+    void Add(const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i) {
+            m_Hash ^= p[i];
+            m_Hash *= 1099511628211ull;
+        }
+    }
+
+    template<class T>
+    void Add(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "hash plain values only");
+        Add(&value, sizeof(T));
+    }
+
+    // Length-prefixed so consecutive strings cannot run together
+    void AddString(const char* s) {
+        uint64_t n = s ? std::strlen(s) : 0;
+        Add(n);
+        Add(s, (size_t)n);
+    }
+
+    uint64_t Value() const { return m_Hash; }
+
+private:
+    uint64_t m_Hash = 14695981039346656037ull;
+};
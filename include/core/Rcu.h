@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Epoch-based read-copy-update for read-mostly data. A writer builds a new immutable copy
+// and swaps it in with one atomic store; readers load the pointer without locking and
+// keep using what they loaded until their scope ends. The old copy is freed only once
+// every reader that could have seen it has left its scope.
+//
+// Readers announce themselves with an RcuReadScope (nestable, one per-thread slot store on
+// the outermost one, no shared counters). Any number of threads may read: reader slots are
+// handed out in blocks of RCU_READER_SLOTS_PER_BLOCK, and a new block is added when every
+// slot is taken.
+
+const int RCU_READER_SLOTS_PER_BLOCK = 64;
+
+class RcuReadScope {
+public:
+    RcuReadScope();
+    ~RcuReadScope();
+
+    RcuReadScope(const RcuReadScope&) = delete;
+    RcuReadScope& operator=(const RcuReadScope&) = delete;
+};
+
+// Starts a new epoch and returns it: a copy unpublished before this call is safe to free
+// once rcuQuiescentEpoch() reaches the returned value
+uint64_t rcuAdvanceEpoch();
+// Oldest epoch any thread is currently reading in (the current epoch + 1 if none is)
+uint64_t rcuQuiescentEpoch();
+
+// Pointer to the current published copy of a T. Publish and Reclaim belong to a single
+// writer thread; Read may be called from any thread inside an RcuReadScope.
+template<class T>
+class RcuPointer {
+public:
+    RcuPointer() = default;
+    ~RcuPointer() {
+        delete m_Current.load();
+        m_Retired.clear();
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    const T* Read() const { return m_Current.load(); }
+
+    // Makes next the current copy; the previous one is retired, then everything no reader
+    // can still see is freed
+    void Publish(std::unique_ptr<const T> next) {
+        const T* old = m_Current.exchange(next.release());
+        if (old) m_Retired.emplace_back(rcuAdvanceEpoch(), std::unique_ptr<const T>(old));
+        Reclaim();
+    }
+
+    void Reclaim() {
+        if (m_Retired.empty()) return;
+        uint64_t safe = rcuQuiescentEpoch();
+        size_t keep = 0;
+        for (auto& r : m_Retired) {
+            if (r.first > safe) m_Retired[keep++] = std::move(r);
+        }
+        m_Retired.resize(keep);
+    }
+
+    size_t RetiredCount() const { return m_Retired.size(); }
+
+private:
+    std::atomic<const T*> m_Current{ nullptr };
+    std::vector<std::pair<uint64_t, std::unique_ptr<const T>>> m_Retired;
+};
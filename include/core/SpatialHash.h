@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform hash grid over the XZ plane. Items are inserted with an axis-aligned rectangle
+// and listed in every cell it overlaps; queries then only visit the cells around the
+// query point or rectangle. Cells are hashed, so the covered area is unbounded.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = 8.0f);
+
+    // Changing the cell size drops every item
+    void SetCellSize(float cellSize);
+    float CellSize() const { return m_CellSize; }
+
+    void Clear();
+    void Insert(uint32_t id, float minX, float minZ, float maxX, float maxZ);
+    // Removes an item inserted with the same rectangle
+    void Remove(uint32_t id, float minX, float minZ, float maxX, float maxZ);
+
+    // Items overlapping the cell that contains (x, z), each listed once; nullptr when empty
+    const std::vector<uint32_t>* CellAt(float x, float z) const;
+
+    // Appends every item overlapping the cells touched by the rectangle, sorted and
+    // without duplicates
+    void Query(float minX, float minZ, float maxX, float maxZ, std::vector<uint32_t>& out) const;
+
+    size_t CellCount() const { return m_Cells.size(); }
+
+private:
+    int cellCoord(float v) const;
+    // Packed through unsigned values: shifting a negative signed cell (everything at -X) is
+    // undefined
+    static int64_t cellKey(int cx, int cz) { return (int64_t)(((uint64_t)(uint32_t)cx << 32) | (uint32_t)cz); }
+
+    std::unordered_map<int64_t, std::vector<uint32_t>> m_Cells;
+    float m_CellSize;
+    float m_InvCellSize;
+};
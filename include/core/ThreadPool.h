@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool for CPU-side jobs (terrain meshing, height grid rebuilds).
+// GL calls must stay on the main thread; tasks only produce data.
+class ThreadPool {
+public:
+    // threads = 0 picks hardware_concurrency - 1 (at least one worker)
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues a task; it runs on some worker at an unspecified later time
+    void Submit(std::function<void()> task);
+
+    // Runs fn(i) for every i in [begin, end) on the workers and the calling thread,
+    // returning once all iterations have finished
+    void ParallelFor(int begin, int end, const std::function<void(int)>& fn);
+
+    unsigned ThreadCount() const { return (unsigned)m_Workers.size(); }
+
+    // Process-wide pool shared by the terrain systems
+    static ThreadPool& Shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_Workers;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    bool m_Stop = false;
+};
@@ -4,16 +4,30 @@
 
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include <cstdint>
 #include <vector>
 #include <string>
 
+class Frustum;
+class RoadIndex;
+
 // Building description used by the scene and city generator
 // type: 0 = no texture, 1 = brick, 2 = metal
-struct BuildingDef { float x; float z; float bw; float bh; float bd; glm::vec3 windowColor; int type = 0; };
-
-void drawBuildings();
-void drawTrees();
-void drawRoads();
+// groundY: terrain height under the building, filled in by addBuilding and kept in step
+// with terrain edits
+struct BuildingDef { float x; float z; float bw; float bh; float bd; glm::vec3 windowColor; int type = 0; float groundY = 0.0f; };
+
+// Every draw* function takes an optional view frustum and skips the props whose bounds lie
+// wholly outside it, counting them in the cull stats below
+void drawBuildings(const Frustum* frustum = nullptr);
+void drawTrees(const Frustum* frustum = nullptr);
+void drawRoads(const Frustum* frustum = nullptr);
+
+// Props drawn and skipped by the draw* calls since the last reset (PlayScene resets once
+// per frame). A road counts as one prop together with its caps.
+struct PropCullStats { int drawn = 0; int culled = 0; };
+void resetPropCullStats();
+PropCullStats getPropCullStats();
 
 // Road type and management (polyline in X,Z world coords)
 struct Road { std::vector<glm::vec2> pts; float halfWidth = 1.2f; bool isMain = false; };
@@ -23,14 +37,20 @@ void clearRoads();
 // Ponds (simple circular lakes)
 void addPond(const glm::vec2 &center, float radius);
 void clearPonds();
-void drawPonds();
+// Replaces the ponds without invalidating the terrain under them, for a height grid that
+// already has their basins carved (world cache restore)
+void setPonds(const std::vector<std::pair<glm::vec2,float>> &ponds);
+void drawPonds(const Frustum* frustum = nullptr);
 // Accessor so terrain can see pond definitions for basin carving
 const std::vector<std::pair<glm::vec2,float>>& getPonds();
 
-// Coins (collectibles)
+// Coins (collectibles); placement is seeded, so the same city always gets the same coins
+const uint32_t COIN_RNG_SEED = 1234567;
 void spawnCoins(int n, float areaRadius);
 void clearCoins();
-void drawCoins();
+// Replaces the coins with uncollected ones at the given (x,z) positions (world cache restore)
+void setCoins(const std::vector<glm::vec2> &positions);
+void drawCoins(const Frustum* frustum = nullptr);
 // Check player position (x,z) for coin pickup within radius; returns number collected this check
 int collectCoinsAt(float x, float z, float pickupRadius = 0.8f);
 int getCollectedCoinsCount();
@@ -39,7 +59,7 @@ int getTotalCoinsCount();
 // Street lights
 void addStreetLight(const glm::vec3 &pos);
 void clearStreetLights();
-void drawStreetLights();
+void drawStreetLights(const Frustum* frustum = nullptr);
 
 // Add or clear buildings (used by city generator)
 void addBuilding(const BuildingDef &b);
@@ -53,6 +73,15 @@ const std::vector<BuildingDef>& getBuildings();
 
 // Accessor for roads
 const std::vector<Road>& getRoads();
+// Proximity index over the segments of getRoads(), kept in step by addRoad / clearRoads
+const RoadIndex& getRoadIndex();
+
+// Tree registry: every tree drawn by drawTrees, including roadside ones
+void addTree(const glm::vec2 &pos);
+void clearTrees();
+// Adds trees along every road (4 per road, alternating sides), skipping spots on any road
+// surface. Generation pass: generateCity runs it once its roads are in.
+void plantRoadsideTrees();
 
 // Accessor for trees
 const std::vector<glm::vec2>& getTrees();
@@ -60,7 +89,8 @@ const std::vector<glm::vec2>& getTrees();
 // Accessor for street lights
 const std::vector<glm::vec3>& getStreetLights();
 
-// Accessor for coins
+// Positions of the uncollected coins, in no particular order; a view of the coin store that
+// pickups, spawns and setCoins change
 const std::vector<glm::vec2>& getCoins();
 
 // Collision query: returns true if a circle centered at (x,z) with given radius
@@ -22,6 +22,7 @@ private:
     GLFWwindow* m_Window{};
     MovableObject m_Player;
     Camera m_Camera;
+    glm::mat4 m_Projection{1.0f}; // set by OnFramebufferResize
     bool m_RMouseDown = false;
     bool m_FirstMouse = true;
     double m_LastX = 0.0;
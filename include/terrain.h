@@ -1,18 +1,275 @@
-// Terrain public API (immediate-mode implementation)
+// Terrain public API
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "core/Rcu.h"
 
-// Returns height of terrain at world position (x, z)
+class Frustum;
+struct TerrainSnapshot;
+
+// Terrain grid layout shared by the chunked mesh and the cached height grid.
+// A tile is (chunkQuads << levels) quads per side, spacing world units apart; tiles repeat
+// across the plane with the central one centred on the origin. Leaf chunks are chunkQuads x
+// chunkQuads quads; every quadtree level above the leaves doubles the chunk footprint and
+// halves its sample density.
+struct TerrainLayout {
+    int chunkQuads = 30;
+    int levels = 2;       // quadtree depth below the root (0 = a single chunk)
+    float spacing = 0.75f;
+};
+
+// Replaces the layout; drops the height cache and every terrain chunk
+void terrainSetLayout(const TerrainLayout& layout);
+const TerrainLayout& terrainGetLayout();
+// Quads per side of the central tile (the one covered by the cached height grid)
+int terrainWorldQuads();
+// Half the central tile width in world units (its grid spans [-half, half] on X and Z)
+float terrainHalfExtent();
+
+// Returns height of terrain at world position (x, z).
+// Inside the terrain grid this is a bilinear lookup into a cached height grid that is
+// rebuilt lazily after mountains or ponds change; outside it falls back to exact evaluation.
+// Safe on any thread: the main thread reads (and refreshes) the terrain as edited so far,
+// other threads the last published snapshot (see terrainPublish), without locking.
 float getTerrainHeight(float x, float z);
 
-// Returns the base terrain height (hills + mountains) without any pond deformation.
+// Exact (uncached) height including pond basins. Slow; use for validation or off-grid queries.
+float getTerrainHeightExact(float x, float z);
+
+// Batched getTerrainHeight: out[i] = height at (xs[i], zs[i]) for i < n. Points on the
+// cached grid are looked up; the rest go through getTerrainHeightExactBatch.
+void getTerrainHeightBatch(const float* xs, const float* zs, float* out, size_t n);
+
+// Batched exact evaluation (base surface, mountain domes, pond basins) running 16 or 8 points per
+// step with AVX-512 or AVX2 when the CPU has them, and a 4-lane generic path otherwise.
+// Runs the same layer stack as getTerrainHeightExact (terrain/TerrainLayers.h), so the two
+// match to float rounding.
+void getTerrainHeightExactBatch(const float* xs, const float* zs, float* out, size_t n);
+
+// First intersection of the ray origin + t * dir (t in [0, maxT]) with the terrain surface
+// that getTerrainHeight describes. Over the cached grid this walks a min/max height
+// pyramid (logarithmic in the grid size); beyond it the ray is marched. Returns false if
+// nothing is hit; a ray starting below the surface hits at t = 0. Safe on any thread; the
+// whole ray is tested against one snapshot.
+bool terrainRaycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& tHit);
+
+// Returns the base terrain height (base surface, erosion and mountains) without any pond
+// deformation.
 float getTerrainBaseHeight(float x, float z);
 
-// Renders the terrain mesh (immediate mode for now)
-void drawTerrain();
+// Uses a heightmap file (format in terrain/TerrainHeightmap.h) in place of the procedural
+// hills; mountains and ponds still apply on top and the edge samples extend past its
+// bounds. The file is memory-mapped, never copied. Returns false (and keeps the hills) if
+// it cannot be opened.
+bool terrainSetHeightmap(const char* path);
+void terrainClearHeightmap();
+
+// Procedural noise base surface (kernels in terrain/TerrainNoise.h). Each octave adds
+// gradient (simplex) or value noise at lacunarity times the previous frequency and gain
+// times its amplitude; the sum is normalised to [-1, 1] ([0, 1] when ridged) and scaled by
+// amplitude. Ridged folds every octave into sharp crests, and a non-zero warpStrength
+// offsets the lookup by a low-frequency noise field (domain warping) for less grid-like
+// shapes. The same seed always gives the same terrain.
+struct TerrainNoise {
+    bool simplex = true;       // false = value noise
+    unsigned seed = 1337;
+    int octaves = 5;
+    float frequency = 0.02f;   // first octave, cycles per world unit
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+    float amplitude = 4.0f;    // world units
+    bool ridged = false;
+    float warpStrength = 0.0f; // world units; 0 disables warping
+    float warpFrequency = 0.01f;
+};
+
+// Uses the noise above in place of the procedural hills; mountains and ponds still apply on
+// top. A heightmap, when set, takes precedence. Both the scalar and batched height paths
+// evaluate it, vectorised like the rest of the batch kernel.
+void terrainSetNoise(const TerrainNoise& noise);
+void terrainClearNoise();
+
+// Erosion pre-pass over the generated surface of the central tile (the cached height grid
+// area), applied before meshing. Hydraulic erosion traces droplets that pick up sediment
+// downhill and drop it where they slow; thermal erosion then slides material off slopes
+// steeper than talusSlope. The work is split into tiles of tileSize samples run on the
+// shared ThreadPool, and the result does not depend on the thread count. The eroded
+// offsets fade out toward the tile border so it still meets the surface beyond.
+struct TerrainErosion {
+    unsigned seed = 1;
+    int droplets = 70000;           // across the whole grid; 0 skips hydraulic erosion
+    int dropletLifetime = 48;       // steps before a droplet stops
+    float inertia = 0.05f;          // 0 = follows the slope, 1 = keeps its heading
+    float sedimentCapacity = 4.0f;
+    float minSedimentCapacity = 0.01f;
+    float erodeSpeed = 0.3f;
+    float depositSpeed = 0.3f;
+    float evaporateSpeed = 0.02f;
+    float gravity = 4.0f;
+    int thermalIterations = 30;     // 0 skips thermal erosion
+    float talusSlope = 0.8f;        // rise over run that material can rest at
+    float thermalRate = 0.5f;
+    int tileSize = 32;              // samples per parallel work tile
+    // Results are stored here keyed by a hash of the layout, base surface and the
+    // parameters above, so a later run with the same inputs loads instead of eroding.
+    // nullptr disables the disk cache.
+    const char* cacheDir = "cache";
+};
+
+// Enables erosion on the current base surface (hills, noise or heightmap). Mountains and
+// ponds are edits and apply on top, uneroded. Changing the layout or base surface while
+// erosion is enabled re-runs it (or loads it from the cache).
+void terrainSetErosion(const TerrainErosion& erosion);
+void terrainClearErosion();
+
+// Strongest mountain influence at (x, z): 1 at a dome centre falling to 0 at its edge
+float getMountainContribution(float x, float z);
+
+// Terrain colour for a vertex with the given height and mountain influence
+glm::vec3 terrainColor(float height, float mountain);
+
+// Renders the terrain as chunked quadtrees, picking each chunk's resolution from its
+// distance to eye (the camera position). The plane is unbounded: the layout above is one
+// tile, and tiles are paged in around focus (the player) as described by TerrainStreaming.
+// With a frustum, chunks wholly outside it are skipped (see TerrainResidencyStats).
+void drawTerrain(const glm::vec3& eye, const glm::vec3& focus, const Frustum* frustum = nullptr);
+
+// Terrain paging. Each tile is one quadtree root; every tile within ringRadius tiles of the
+// focus tile (a (2 * ringRadius + 1)^2 square) is requested each frame and meshed on worker
+// threads, so the frame never waits for generation. When the chunk meshes exceed
+// memoryBudget bytes the least recently drawn chunks are released. compactVertices stores
+// chunks in the 8-byte TerrainCompactVertex format instead of 36-byte float vertices (so
+// the same budget holds 4.5x the terrain); it needs GL 3.0 and falls back to floats.
+struct TerrainStreaming {
+    int ringRadius = 2;
+    size_t memoryBudget = (size_t)64 << 20;
+    bool compactVertices = true;
+};
+void terrainSetStreaming(const TerrainStreaming& streaming);
+const TerrainStreaming& terrainGetStreaming();
+
+struct TerrainResidencyStats {
+    size_t residentChunks = 0;  // chunk meshes on the GPU
+    size_t residentBytes = 0;   // their vertex buffer size
+    size_t budgetBytes = 0;
+    size_t drawnChunks = 0;     // drawn last frame
+    size_t culledChunks = 0;    // resident nodes skipped last frame as outside the frustum
+    size_t pendingBuilds = 0;   // chunks being meshed on worker threads
+    size_t ringTiles = 0;       // tiles requested around the focus
+    size_t residentTiles = 0;   // of those, tiles whose root chunk is resident
+    unsigned long long chunksBuilt = 0;   // uploads since start
+    unsigned long long chunksEvicted = 0; // releases forced by the memory budget
+    bool compactVertices = false; // resident chunks use the compact vertex format
+    size_t bytesPerVertex = 0;
+};
+TerrainResidencyStats terrainResidencyStats();
 
 // Configure procedural "mountains" that add on top of base height
 // center = (x,z) in world units within the terrain range, radius in world units, height in world units
 void terrainAddMountain(const glm::vec2& center, float radius, float height);
 void terrainClearMountains();
+
+// Marks the whole terrain changed: the cached height grid is rebuilt and every chunk is
+// regenerated. Used when the layout or base source changes.
+void terrainInvalidateHeightCache();
+
+// Marks only the terrain inside the rectangle changed. The mountain and pond edit
+// functions call this with the feature's footprint, so just the overlapping cached heights
+// and chunks are regenerated.
+void terrainInvalidateRegion(float minX, float minZ, float maxX, float maxZ);
+
+// Picks up a changed pond list (getPonds) without refreshing the cached grid, for ponds
+// whose basins the grid already has (see terrainLoadHeightCache). Everything else built
+// from the terrain is treated as changed.
+void terrainReloadPonds();
+
+// True if an edit made after the given revision touched the rectangle
+bool terrainRegionChangedSince(unsigned revision, float minX, float minZ, float maxX, float maxZ);
+
+// Rebuilds the cached height grid now if it is stale (in parallel on the shared ThreadPool)
+// and publishes it. Call from the main thread before handing height queries to worker
+// threads; the same as terrainPublish.
+void terrainUpdateHeightCache();
+
+// A copy of the cached height grid, brought up to date first: dim x dim samples, row-major
+// in z, with sample (0, 0) at world (origin, origin). Main thread only; valid until the next
+// call.
+const float* terrainHeightCache(int& dim, float& origin, float& spacing);
+
+// Storage for the cached height grid. Grids with at least compressFromDim samples per side
+// are held as tiles of tileSize x tileSize cells, each quantized to 8 or 12 bits above its
+// minimum (8 when the error stays within maxError), and decoded on demand into a per-thread
+// LRU of cachedTiles float tiles; getTerrainHeight reads through it without locking.
+// Smaller grids stay plain floats. Compressed grids have no raycast pyramid (rays march
+// instead), and terrainHeightCache returns a decoded copy.
+struct TerrainHeightStorage {
+    int compressFromDim = 2048;
+    int tileSize = 64;
+    float maxError = 0.01f;
+    int cachedTiles = 64;
+};
+void terrainSetHeightStorage(const TerrainHeightStorage& storage);
+
+struct TerrainHeightStorageStats {
+    bool compressed = false;
+    int dim = 0;                 // samples per side
+    size_t floatBytes = 0;       // what the grid takes as plain floats
+    size_t storedBytes = 0;      // what it takes as stored (floats, or encoded tiles)
+    size_t decodedBytes = 0;     // decoded tiles held by the LRUs of every thread
+    size_t tiles = 0;
+    size_t tiles8Bit = 0;        // the rest use 12 bits
+    unsigned long long cacheHits = 0;   // summed over threads, since start
+    unsigned long long cacheMisses = 0;
+
+    double HitRate() const {
+        unsigned long long total = cacheHits + cacheMisses;
+        return total ? (double)cacheHits / total : 0.0;
+    }
+};
+TerrainHeightStorageStats terrainHeightStorageStats();
+
+// Installs a grid saved from terrainHeightCache as the cache instead of rebuilding it. It
+// must have been produced for the current layout, base surface and features; returns false
+// (and keeps the current cache) if its placement does not match the layout.
+bool terrainLoadHeightCache(const float* heights, int dim, float origin, float spacing);
+
+// Makes the edits made since the last call visible to other threads. Off the main thread,
+// mountains, ponds, the base surface and the cached height grid (with its raycast pyramid)
+// are read from an immutable snapshot that this brings up to date and swaps in atomically
+// (read-copy-update), so those reads never lock, never rebuild anything and never see half
+// an edit. Grid rows and tiles are shared between snapshots and copied only where an edit
+// changes them. Call once per frame from the main thread.
+void terrainPublish();
+
+// Pins the published terrain snapshot for the calling thread while it lives, so every
+// height query it makes (getTerrainHeight, terrainRaycast, terrainFeatures, ...) reads the
+// same one even across a publish. Nestable; the innermost scope keeps the outer pin. On the
+// main thread queries read the edit copy, and this pins nothing.
+class TerrainReadScope {
+public:
+    TerrainReadScope();
+    ~TerrainReadScope();
+
+    TerrainReadScope(const TerrainReadScope&) = delete;
+    TerrainReadScope& operator=(const TerrainReadScope&) = delete;
+
+    // terrainRevision() as of the pinned snapshot
+    unsigned Revision() const;
+
+private:
+    RcuReadScope m_Rcu;
+    const TerrainSnapshot* m_Outer;
+};
+
+// Edit counter, incremented whenever mountains or ponds change. Retained data derived from
+// the terrain stores the revision it was built at; when it differs, the data only needs
+// rebuilding if terrainRegionChangedSince reports an edit over its area.
+unsigned terrainRevision();
+
+// Hash of everything the terrain height is derived from except ponds: the layout, base
+// surface (heightmap path and header, or noise parameters), erosion settings, mountains and
+// the height storage settings (which quantize large grids). Caches of data generated on top
+// of the terrain include it in their keys.
+uint64_t terrainContentKey();
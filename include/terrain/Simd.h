@@ -0,0 +1,157 @@
+#pragma once
+
+// Portable SIMD lanes built on GCC/Clang vector extensions.
+// Kernels are written once as templates over a lane type (float for scalar, f4/f8/f16 for
+// 4/8/16 lanes) and only use the helpers below plus ordinary arithmetic and comparisons.
+// An ISA-specific entry point instantiates the kernel inside a function carrying a target
+// attribute (see SIMD_TARGET_AVX2), so the same source compiles to SSE, AVX2 or AVX-512
+// without per-file compiler flags. Everything here is force-inlined so no vector-typed
+// function ever crosses an ABI boundary.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+
+// The helpers take and return vector types but are always inlined into a target-attributed
+// entry point, so GCC's "vector return changes the ABI" note does not apply. Suppressed for
+// this header only; files instantiating kernels over the lane types do the same locally.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_HAS_X86_DISPATCH 1
+#define SIMD_TARGET_AVX2   __attribute__((target("avx2,fma"), flatten))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f"), flatten))
+#else
+#define SIMD_HAS_X86_DISPATCH 0
+#endif
+
+namespace simd {
+
+typedef float   f4  __attribute__((vector_size(16)));
+typedef float   f8  __attribute__((vector_size(32)));
+typedef float   f16 __attribute__((vector_size(64)));
+typedef int32_t i4  __attribute__((vector_size(16)));
+typedef int32_t i8  __attribute__((vector_size(32)));
+typedef int32_t i16 __attribute__((vector_size(64)));
+typedef uint32_t u4  __attribute__((vector_size(16)));
+typedef uint32_t u8  __attribute__((vector_size(32)));
+typedef uint32_t u16 __attribute__((vector_size(64)));
+
+template<class V> struct Traits;
+template<> struct Traits<float> { typedef int32_t Int; typedef uint32_t UInt; enum { Width = 1 }; };
+template<> struct Traits<f4>    { typedef i4 Int;      typedef u4 UInt;       enum { Width = 4 }; };
+template<> struct Traits<f8>    { typedef i8 Int;      typedef u8 UInt;       enum { Width = 8 }; };
+template<> struct Traits<f16>   { typedef i16 Int;     typedef u16 UInt;      enum { Width = 16 }; };
+
+template<class V> using IntOf = typename Traits<V>::Int;
+// Unsigned lanes, for hashing (wrapping multiplies and logical shifts)
+template<class V> using UIntOf = typename Traits<V>::UInt;
+template<class V> constexpr bool isScalar() { return std::is_same<V, float>::value; }
+
+template<class V> SIMD_INLINE V splat(float s) { return V{} + s; }
+
+template<class V> SIMD_INLINE V load(const float* p) {
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template<class V> SIMD_INLINE void store(float* p, V v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+template<class V> SIMD_INLINE V vmin(V a, V b) { return a < b ? a : b; }
+template<class V> SIMD_INLINE V vmax(V a, V b) { return a > b ? a : b; }
+
+template<class V> SIMD_INLINE V vfloor(V x) {
+    if constexpr (isScalar<V>()) {
+        return std::floor(x);
+    } else {
+        // Truncate toward zero then step down where that rounded up (valid for |x| < 2^31)
+        V t = __builtin_convertvector(__builtin_convertvector(x, IntOf<V>), V);
+        return t > x ? t - 1.0f : t;
+    }
+}
+
+template<class V> SIMD_INLINE IntOf<V> toInt(V x) {
+    if constexpr (isScalar<V>()) return (int32_t)x;
+    else return __builtin_convertvector(x, IntOf<V>);
+}
+
+template<class V> SIMD_INLINE V toFloat(IntOf<V> i) {
+    if constexpr (isScalar<V>()) return (float)i;
+    else return __builtin_convertvector(i, V);
+}
+
+// Reinterpret signed lanes as unsigned and back (no value conversion)
+template<class V> SIMD_INLINE UIntOf<V> asUInt(IntOf<V> i) { return (UIntOf<V>)i; }
+template<class V> SIMD_INLINE IntOf<V> asInt(UIntOf<V> u) { return (IntOf<V>)u; }
+
+template<class V> SIMD_INLINE V vabs(V x) { return x < 0.0f ? -x : x; }
+
+// Square root; vector lanes use a bit-trick reciprocal root refined by three Newton steps
+// (full float precision) since the extensions have no portable sqrt.
+template<class V> SIMD_INLINE V vsqrt(V x) {
+    if constexpr (isScalar<V>()) {
+        return std::sqrt(x);
+    } else {
+        IntOf<V> xi;
+        std::memcpy(&xi, &x, sizeof(V));
+        IntOf<V> yi = 0x5f375a86 - (xi >> 1);
+        V y;
+        std::memcpy(&y, &yi, sizeof(V));
+        V hx = x * 0.5f;
+        y = y * (1.5f - hx * y * y);
+        y = y * (1.5f - hx * y * y);
+        y = y * (1.5f - hx * y * y);
+        return x > 0.0f ? x * y : V{};
+    }
+}
+
+// sin and cos together: Cody-Waite reduction to [-pi/4, pi/4] plus minimax polynomials
+// (Cephes sinf/cosf), accurate to a few ulp for |x| up to a few thousand.
+template<class V> SIMD_INLINE void vsincos(V x, V& s, V& c) {
+    IntOf<V> q = toInt<V>(vfloor(x * 0.63661977236f + 0.5f)); // x * 2/pi, rounded
+    V qf = toFloat<V>(q);
+    V r = x - qf * 1.5703125f;
+    r = r - qf * 4.837512969970703125e-4f;
+    r = r - qf * 7.54978995489188216e-8f;
+    V r2 = r * r;
+    V ps = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    V pc = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+    // Quadrant: swap sin/cos on odd quadrants, negate per quadrant
+    auto swap = (q & 1) != 0;
+    V ss = swap ? pc : ps;
+    V cc = swap ? ps : pc;
+    s = (q & 2) != 0 ? -ss : ss;
+    c = ((q + 1) & 2) != 0 ? -cc : cc;
+}
+
+// Runtime CPU feature checks for picking an entry point
+inline bool cpuHasAVX2() {
+#if SIMD_HAS_X86_DISPATCH
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+inline bool cpuHasAVX512() {
+#if SIMD_HAS_X86_DISPATCH
+    return __builtin_cpu_supports("avx512f");
+#else
+    return false;
+#endif
+}
+
+} // namespace simd
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
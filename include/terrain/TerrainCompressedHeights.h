@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Square height grid held as compressed tiles, for worlds whose float grid would not fit in
+// memory. Tile (tx, tz) covers cells [tx * tileSize, (tx + 1) * tileSize) on each axis and
+// stores its (tileSize + 1)^2 corner samples, so every bilinear lookup reads a single tile.
+// Samples are kept as 8- or 12-bit steps above the tile minimum: 8 bits when that keeps the
+// error under maxError, 12 bits otherwise. Tiles are decoded on demand into a small
+// per-thread LRU of float tiles.
+//
+// Encoded tiles are immutable and shared between copies: EncodeTile swaps in a new tile, so a
+// copy handed to other threads never sees a later edit of the original. Lookups never lock;
+// each thread's LRU is keyed by tile ids that are never reused. Encoding distinct tiles in
+// parallel is safe too, but not while the same object is looked up.
+class TerrainCompressedHeights {
+public:
+    struct Stats {
+        size_t tiles = 0;
+        size_t tiles8Bit = 0;
+        size_t encodedBytes = 0;  // compressed samples plus per-tile headers
+        size_t decodedBytes = 0;  // float tiles held by the LRUs of every thread
+        unsigned long long hits = 0;   // summed over threads, since start
+        unsigned long long misses = 0;
+    };
+
+    // Drops every tile and sets up an empty dim x dim grid with sample (0, 0) at world
+    // (origin, origin). Each thread keeps up to cachedTiles decoded tiles.
+    void Reset(int dim, float origin, float spacing, int tileSize, float maxError, int cachedTiles);
+    void Clear();
+    bool Empty() const { return m_Tiles.empty(); }
+
+    int TilesPerSide() const { return m_TilesPerSide; }
+    int TileSize() const { return m_TileSize; }
+    // First grid sample of a tile and the number of samples per side it stores
+    void TileSamples(int tx, int tz, int& i0, int& j0, int& n) const;
+    // Tiles overlapping grid samples [i0, i1] x [j0, j1] (a sample on a tile border belongs
+    // to both tiles)
+    void TilesCovering(int i0, int j0, int i1, int j1, int& tx0, int& tz0, int& tx1, int& tz1) const;
+
+    // Compresses one tile from its n x n samples (as given by TileSamples, row-major). Rows
+    // and columns past the grid edge are ignored.
+    void EncodeTile(int tx, int tz, const float* samples);
+
+    // Bilinear height at world (x, z); the point must lie on the grid
+    float HeightAt(float x, float z) const;
+    // The same for n points
+    void HeightBatch(const float* xs, const float* zs, float* out, size_t n) const;
+    // Decodes the whole grid, row-major
+    void Decode(std::vector<float>& out) const;
+
+    Stats GetStats() const;
+
+private:
+    struct Tile {
+        float minH = 0.0f;
+        float step = 0.0f;   // height of one quantization step
+        uint8_t bits = 0;    // 8 or 12
+        uint64_t id = 0;     // unique per encoding, the decoded-tile cache key
+        std::vector<uint8_t> data;
+    };
+
+    void decodeTile(const Tile& tile, float* out) const;
+    const float* cachedTile(const Tile& tile) const;
+
+    std::vector<std::shared_ptr<const Tile>> m_Tiles; // null until encoded
+    int m_TilesPerSide = 0;
+    int m_TileSize = 64;
+    int m_Dim = 0;
+    float m_Origin = 0.0f;
+    float m_Spacing = 1.0f;
+    float m_MaxError = 0.01f;
+    int m_CachedTiles = 64;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../terrain.h"
+
+class ThreadPool;
+
+// Height offsets an erosion pass (see TerrainErosion in terrain.h) made to a square grid of
+// samples. The offsets are added to the base surface, so the eroded terrain can still be
+// evaluated at any point: HeightAt interpolates them bilinearly and is 0 off the grid.
+class TerrainErosionMap {
+public:
+    bool Empty() const { return m_Offsets.empty(); }
+    void Clear();
+
+    // Erodes a copy of the dim x dim row-major grid (heights[j * dim + i], sample (0, 0) at
+    // world (origin, origin)) and keeps eroded - original. Tiles are processed in four
+    // passes so that no two tiles running at once touch the same samples, which keeps the
+    // result identical for any number of threads.
+    void Compute(const TerrainErosion& params, const std::vector<float>& heights, int dim,
+                 float origin, float spacing, ThreadPool& pool);
+
+    // Cache file: header (magic, version, key, grid placement) then the offsets. Load fails
+    // if the file is missing, damaged or was written for a different key or grid.
+    bool Load(const std::string& path, uint64_t key, int dim, float origin, float spacing);
+    bool Save(const std::string& path, uint64_t key) const;
+
+    float HeightAt(float x, float z) const;
+
+private:
+    std::vector<float> m_Offsets;
+    int m_Dim = 0;
+    float m_Origin = 0.0f;
+    float m_Spacing = 1.0f;
+};
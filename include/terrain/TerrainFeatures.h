@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <memory>
+#include "../core/SpatialHash.h"
+#include "TerrainHeightmap.h"
+#include "TerrainErosion.h"
+#include "../terrain.h"
+
+// Cell size of the feature indexes; about the diameter of a typical dome or pond
+const float TERRAIN_FEATURE_CELL = 16.0f;
+
+// Terrain features stored as structure-of-arrays so batched evaluation can stream each
+// field across SIMD lanes. Published copies are immutable snapshots (see terrainFeatures).
+struct TerrainFeatureArrays {
+    // Base surface from a heightmap file instead of the procedural hills, when one is set
+    const TerrainHeightmap* heightmap = nullptr;
+    // Otherwise, noise in place of the hills when one is set
+    const TerrainNoise* noise = nullptr;
+    // Offsets from the erosion pre-pass, added to whichever base surface is in use
+    const TerrainErosionMap* erosion = nullptr;
+    // Keep the three above alive for as long as any snapshot refers to them
+    std::shared_ptr<const TerrainHeightmap> heightmapOwner;
+    std::shared_ptr<const TerrainNoise> noiseOwner;
+    std::shared_ptr<const TerrainErosionMap> erosionOwner;
+
+    // Mountain domes: adds height * (1 - d/radius)^2 inside radius
+    std::vector<float> mountainX, mountainZ, mountainRadius, mountainHeight;
+    // Pond basins: clamps the terrain to centerBase - maxDepth * (1 - d/radius)^2 inside radius
+    std::vector<float> pondX, pondZ, pondRadius, pondCenterBase, pondMaxDepth;
+
+    // Footprint (bounding square of the radius) indexes; ids are positions in the arrays
+    SpatialHash mountainIndex{ TERRAIN_FEATURE_CELL };
+    SpatialHash pondIndex{ TERRAIN_FEATURE_CELL };
+
+    size_t MountainCount() const { return mountainX.size(); }
+    size_t PondCount() const { return pondX.size(); }
+};
+
+// The features height queries on this thread read: on the main thread the edit copy, on
+// others the pinned (TerrainReadScope) or published terrain snapshot. Edits never change a
+// published snapshot: terrainPublish swaps in a new one, and the old one is freed once no
+// reader can still hold it. Other threads must read inside an RcuReadScope (core/Rcu.h) and
+// not keep the reference past it; the main thread may keep it until its next edit.
+const TerrainFeatureArrays& terrainFeatures();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "TerrainSharedGrid.h"
+
+// Min/max mip pyramid over a square height grid, for ray queries against the bilinear
+// surface the grid describes (the one getTerrainHeight interpolates). Level 0 holds the
+// height range of each grid cell; every level above halves the resolution. A ray walks the
+// pyramid top-down, skipping any node it passes entirely above, so a query visits
+// O(log n) nodes on open terrain instead of marching every cell.
+//
+// Levels are TerrainSharedGrids, so copying a pyramid is cheap and an Update copies only
+// the rows it changes. The pyramid keeps no reference to the height grid: Update and
+// Raycast are handed the grid (or a copy of it) that it was last built or updated from.
+class TerrainHeightPyramid {
+public:
+    // Builds every level from a dim x dim grid whose sample (0, 0) lies at world
+    // (origin, origin)
+    void Build(const TerrainSharedGrid& heights, float origin, float spacing);
+    // Refreshes the nodes covering grid samples [i0, i1] x [j0, j1] after they changed
+    void Update(const TerrainSharedGrid& heights, int i0, int j0, int i1, int j1);
+    void Clear();
+    bool Empty() const { return m_Levels.empty(); }
+
+    // World-space XZ bounds of the grid
+    float MinCoord() const { return m_Origin; }
+    float MaxCoord() const { return m_Origin + m_Cells * m_Spacing; }
+
+    // First t in [tMin, tMax] where origin + t * dir meets or is below the surface inside
+    // the grid; false if there is none
+    bool Raycast(const TerrainSharedGrid& heights, const glm::vec3& origin, const glm::vec3& dir,
+                 float tMin, float tMax, float& tHit) const;
+
+private:
+    struct Level {
+        int size = 0; // nodes per side
+        TerrainSharedGrid minH, maxH;
+    };
+
+    bool hitCell(const TerrainSharedGrid& heights, int ci, int cj, const glm::vec3& o, const glm::vec3& d,
+                 float ta, float tb, float& tHit) const;
+
+    std::vector<Level> m_Levels;
+    int m_Cells = 0; // cells per side (dim - 1)
+    float m_Origin = 0.0f;
+    float m_Spacing = 1.0f;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk heightmap: a width x height grid of 16-bit quantized samples split into square
+// tiles. Layout (little-endian):
+//   TerrainHeightmapHeader
+//   uint64_t tileOffsets[tilesX * tilesZ]  byte offset of each tile, row-major in z; 0 = no data
+//   tiles: tileSize * tileSize uint16_t samples each, row-major in z
+// Sample (i, j) lies at world (originX + i * spacing, originZ + j * spacing) and decodes to
+// heightMin + q * heightScale. Edge tiles are padded to the full tile size.
+struct TerrainHeightmapHeader {
+    char magic[8];          // "TERRHMAP"
+    uint32_t version;
+    uint32_t tileSize;      // samples per tile side
+    uint32_t width, height; // samples on X and Z
+    uint32_t tilesX, tilesZ;
+    float originX, originZ;
+    float spacing;
+    float heightMin, heightScale;
+    uint32_t reserved;
+};
+static_assert(sizeof(TerrainHeightmapHeader) == 56, "heightmap header layout changed");
+
+// Largest grid and tile sides accepted. They keep every size and index computed from a
+// header far from overflowing, whatever the file claims.
+const uint32_t HEIGHTMAP_MAX_SIDE = 1u << 20;
+const uint32_t HEIGHTMAP_MAX_TILE_SIZE = 4096;
+
+// Read-only view of a heightmap file. The file is mmap'ed rather than read, so opening a
+// multi-gigabyte world is cheap and the OS only pages in the tiles that are sampled.
+// Safe to sample from several threads at once.
+class TerrainHeightmap {
+public:
+    TerrainHeightmap() = default;
+    ~TerrainHeightmap();
+
+    TerrainHeightmap(const TerrainHeightmap&) = delete;
+    TerrainHeightmap& operator=(const TerrainHeightmap&) = delete;
+
+    // Maps and validates the file; prints the reason and returns false if it is unusable
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return m_Data != nullptr; }
+
+    const TerrainHeightmapHeader& Header() const { return *m_Header; }
+
+    // Decoded sample; coordinates are clamped to the grid
+    float Sample(int i, int j) const;
+    // Bilinear height at world (x, z); clamps to the edge samples outside the grid
+    float HeightAt(float x, float z) const;
+
+    // Quantizes a row-major width x height grid (heights[j * width + i]) and writes it in the
+    // format above. Used to convert DEMs or bake procedural worlds.
+    static bool Write(const std::string& path, const float* heights, int width, int height,
+                      float originX, float originZ, float spacing, int tileSize = 256);
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+    const TerrainHeightmapHeader* m_Header = nullptr;
+    const uint64_t* m_TileOffsets = nullptr;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+// Composable terrain height layers. A layer maps the height y at (x, z) to a new height:
+// base surfaces replace it, erosion and domes add to it, basins clamp it. Layers are plain
+// structs composed with TerrainLayerStack at compile time, so a stack is one force-inlined
+// kernel with no per-sample indirection; instantiated with float it is the scalar height
+// function, with f4/f8/f16 the batched one (see Simd.h), so both compute the same values.
+//
+// Layer interface (duck-typed; a TerrainLayerStack is itself a layer, so stacks nest):
+//   void Bind(const TerrainFeatureArrays& f)   take parameters from a feature snapshot
+//   void BeginBlock(const TerrainLayerBlock&)  per-block setup: feature lookups, gathers
+//   void BeginPoint(float x, float z)          the same for a single point
+//   template<class V> V Apply(V x, V z, V y, size_t lane) const
+// lane is the position of the first lane in the current block (0 after BeginPoint).
+//
+// The built-in terrain is the stack base surface, erosion, domes, basins. Which base
+// surface and whether erosion applies are picked at runtime from the snapshot, once per
+// call, between separately compiled stacks (see terrainLayerHeight).
+
+#include <algorithm>
+#include <vector>
+#include "Simd.h"
+#include "TerrainNoise.h"
+#include "TerrainFeatures.h"
+
+// Points are evaluated in blocks; each block only visits the features whose footprint
+// overlaps the block's bounding box. Blocks spread over more than TERRAIN_LAYER_MAX_CELLS
+// feature cells are not spatially coherent and fall back to one point at a time.
+const size_t TERRAIN_LAYER_BLOCK = 64;
+const float TERRAIN_LAYER_MAX_CELLS = 32.0f;
+
+struct TerrainLayerBlock {
+    const float* xs;
+    const float* zs;
+    size_t n; // at most TERRAIN_LAYER_BLOCK
+    float minX, minZ, maxX, maxZ;
+};
+
+// Ids of the features a block or point has to visit
+struct TerrainFeatureIds {
+    const uint32_t* ids = nullptr;
+    size_t count = 0;
+
+    TerrainFeatureIds() = default;
+    TerrainFeatureIds(const std::vector<uint32_t>* v) { if (v) { ids = v->data(); count = v->size(); } }
+};
+
+// Gentle procedural hills
+struct TerrainHillsLayer {
+    void Bind(const TerrainFeatureArrays&) {}
+    void BeginBlock(const TerrainLayerBlock&) {}
+    void BeginPoint(float, float) {}
+
+    template<class V>
+    SIMD_INLINE V Apply(V x, V z, V, size_t) const {
+        V sx, cx, sz, cz;
+        simd::vsincos(x * 0.2f, sx, cx);
+        simd::vsincos(z * 0.2f, sz, cz);
+        return 0.5f * sx * cz;
+    }
+};
+
+// Noise base surface (TerrainNoise.h)
+struct TerrainNoiseLayer {
+    const TerrainNoise* noise = nullptr;
+
+    void Bind(const TerrainFeatureArrays& f) { noise = f.noise; }
+    void BeginBlock(const TerrainLayerBlock&) {}
+    void BeginPoint(float, float) {}
+
+    template<class V>
+    SIMD_INLINE V Apply(V x, V z, V, size_t) const { return simd::terrainNoiseLanes<V>(x, z, *noise); }
+};
+
+// Layers reading a sampled grid: bilinear gathers are scalar, so each block's values are
+// fetched once up front and the lanes load them
+template<class Source>
+struct TerrainGatherLayer {
+    const Source* source = nullptr;
+    float values[TERRAIN_LAYER_BLOCK];
+
+    void BeginBlock(const TerrainLayerBlock& b) {
+        for (size_t k = 0; k < b.n; ++k) values[k] = source->HeightAt(b.xs[k], b.zs[k]);
+        // Padding lanes of the tail vector read defined values
+        for (size_t k = b.n; k < TERRAIN_LAYER_BLOCK && (k & 15); ++k) values[k] = 0.0f;
+    }
+    void BeginPoint(float x, float z) { values[0] = source->HeightAt(x, z); }
+};
+
+// Heightmap base surface
+struct TerrainHeightmapLayer : TerrainGatherLayer<TerrainHeightmap> {
+    void Bind(const TerrainFeatureArrays& f) { source = f.heightmap; }
+
+    template<class V>
+    SIMD_INLINE V Apply(V, V, V, size_t lane) const { return simd::load<V>(values + lane); }
+};
+
+// Erosion offsets, added to the surface below
+struct TerrainErosionLayer : TerrainGatherLayer<TerrainErosionMap> {
+    void Bind(const TerrainFeatureArrays& f) { source = f.erosion; }
+
+    template<class V>
+    SIMD_INLINE V Apply(V, V, V y, size_t lane) const { return y + simd::load<V>(values + lane); }
+};
+
+// Mountain domes: adds height * (1 - d/radius)^2 inside radius
+struct TerrainDomeLayer {
+    const TerrainFeatureArrays* f = nullptr;
+    std::vector<uint32_t> blockIds;
+    TerrainFeatureIds active;
+
+    void Bind(const TerrainFeatureArrays& features) { f = &features; }
+    void BeginBlock(const TerrainLayerBlock& b) {
+        blockIds.clear();
+        f->mountainIndex.Query(b.minX, b.minZ, b.maxX, b.maxZ, blockIds);
+        active = &blockIds;
+    }
+    void BeginPoint(float x, float z) { active = f->mountainIndex.CellAt(x, z); }
+
+    template<class V>
+    SIMD_INLINE V Apply(V x, V z, V y, size_t) const {
+        for (size_t i = 0; i < active.count; ++i) {
+            uint32_t k = active.ids[i];
+            V dx = x - f->mountainX[k];
+            V dz = z - f->mountainZ[k];
+            V dist = simd::vsqrt(dx*dx + dz*dz);
+            V t = simd::vmax(1.0f - dist * (1.0f / f->mountainRadius[k]), V{});
+            y += f->mountainHeight[k] * (t * t);
+        }
+        return y;
+    }
+};
+
+// Pond basins: clamps the terrain to centerBase - maxDepth * (1 - d/radius)^2 inside radius
+struct TerrainBasinLayer {
+    const TerrainFeatureArrays* f = nullptr;
+    std::vector<uint32_t> blockIds;
+    TerrainFeatureIds active;
+
+    void Bind(const TerrainFeatureArrays& features) { f = &features; }
+    void BeginBlock(const TerrainLayerBlock& b) {
+        blockIds.clear();
+        f->pondIndex.Query(b.minX, b.minZ, b.maxX, b.maxZ, blockIds);
+        active = &blockIds;
+    }
+    void BeginPoint(float x, float z) { active = f->pondIndex.CellAt(x, z); }
+
+    template<class V>
+    SIMD_INLINE V Apply(V x, V z, V y, size_t) const {
+        for (size_t i = 0; i < active.count; ++i) {
+            uint32_t k = active.ids[i];
+            float r = f->pondRadius[k];
+            V dx = x - f->pondX[k];
+            V dz = z - f->pondZ[k];
+            V d2 = dx*dx + dz*dz;
+            // Inside test on the squared distance, so every lane width agrees exactly on the
+            // rim, where the basin edge is a step
+            V falloff = 1.0f - simd::vsqrt(d2) * (1.0f / r);
+            V depressed = f->pondCenterBase[k] - f->pondMaxDepth[k] * (falloff * falloff);
+            y = d2 < r*r ? simd::vmin(y, depressed) : y;
+        }
+        return y;
+    }
+};
+
+// Layers applied in order, bottom first
+template<class... Layers>
+struct TerrainLayerStack;
+
+template<>
+struct TerrainLayerStack<> {
+    void Bind(const TerrainFeatureArrays&) {}
+    void BeginBlock(const TerrainLayerBlock&) {}
+    void BeginPoint(float, float) {}
+
+    template<class V>
+    SIMD_INLINE V Apply(V, V, V y, size_t) const { return y; }
+};
+
+template<class First, class... Rest>
+struct TerrainLayerStack<First, Rest...> {
+    First first;
+    TerrainLayerStack<Rest...> rest;
+
+    void Bind(const TerrainFeatureArrays& f) {
+        first.Bind(f);
+        rest.Bind(f);
+    }
+    void BeginBlock(const TerrainLayerBlock& b) {
+        first.BeginBlock(b);
+        rest.BeginBlock(b);
+    }
+    void BeginPoint(float x, float z) {
+        first.BeginPoint(x, z);
+        rest.BeginPoint(x, z);
+    }
+
+    template<class V>
+    SIMD_INLINE V Apply(V x, V z, V y, size_t lane) const {
+        return rest.template Apply<V>(x, z, first.template Apply<V>(x, z, y, lane), lane);
+    }
+
+    // Height at one point (starting from 0)
+    SIMD_INLINE float HeightAt(float x, float z) {
+        BeginPoint(x, z);
+        return Apply<float>(x, z, 0.0f, 0);
+    }
+
+    // out[i] = height at (xs[i], zs[i]), V lanes at a time
+    template<class V>
+    SIMD_INLINE void Evaluate(const float* xs, const float* zs, float* out, size_t n) {
+        const float cellArea = TERRAIN_FEATURE_CELL * TERRAIN_FEATURE_CELL;
+        for (size_t b = 0; b < n; b += TERRAIN_LAYER_BLOCK) {
+            TerrainLayerBlock block{ xs + b, zs + b, std::min(TERRAIN_LAYER_BLOCK, n - b), xs[b], zs[b], xs[b], zs[b] };
+            for (size_t k = 1; k < block.n; ++k) {
+                float x = block.xs[k], z = block.zs[k];
+                block.minX = x < block.minX ? x : block.minX; block.maxX = x > block.maxX ? x : block.maxX;
+                block.minZ = z < block.minZ ? z : block.minZ; block.maxZ = z > block.maxZ ? z : block.maxZ;
+            }
+            float cells = (block.maxX - block.minX + TERRAIN_FEATURE_CELL) *
+                          (block.maxZ - block.minZ + TERRAIN_FEATURE_CELL) / cellArea;
+            if (cells <= TERRAIN_LAYER_MAX_CELLS) evaluateBlock<V>(block, out + b);
+            else for (size_t k = b; k < b + block.n; ++k) out[k] = HeightAt(xs[k], zs[k]);
+        }
+    }
+
+private:
+    template<class V>
+    SIMD_INLINE void evaluateBlock(const TerrainLayerBlock& b, float* out) {
+        const size_t W = simd::Traits<V>::Width;
+        BeginBlock(b);
+        size_t i = 0;
+        for (; i + W <= b.n; i += W) {
+            V x = simd::load<V>(b.xs + i), z = simd::load<V>(b.zs + i);
+            simd::store(out + i, Apply<V>(x, z, V{}, i));
+        }
+        if (i < b.n) {
+            // Tail: pad a full vector so the remainder uses the same code path
+            float tx[W] = {}, tz[W] = {}, ty[W];
+            for (size_t k = i; k < b.n; ++k) {
+                tx[k - i] = b.xs[k];
+                tz[k - i] = b.zs[k];
+            }
+            simd::store(ty, Apply<V>(simd::load<V>(tx), simd::load<V>(tz), V{}, i));
+            for (size_t k = i; k < b.n; ++k) out[k] = ty[k - i];
+        }
+    }
+};
+
+// How much of the built-in stack to evaluate
+enum class TerrainLayers {
+    Surface, // base surface only (heightmap, noise or hills)
+    Base,    // plus erosion and mountain domes
+    Full,    // plus pond basins: the terrain height
+};
+
+// The built-in stack at one point for a feature snapshot; scalar instantiation of the same
+// kernels getTerrainHeightExactBatch runs
+float terrainLayerHeight(const TerrainFeatureArrays& f, float x, float z, TerrainLayers layers);
+// The full stack at n points for a feature snapshot, on the widest lanes the CPU has
+void terrainLayerHeightBatch(const TerrainFeatureArrays& f, const float* xs, const float* zs, float* out, size_t n);
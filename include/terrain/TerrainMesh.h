@@ -0,0 +1,82 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Interleaved terrain vertex as uploaded to the GPU. Normal and colour are baked when the
+// chunk is built, so drawing does no per-vertex work on the CPU.
+struct TerrainVertex {
+    float x, y, z;
+    float nx, ny, nz;
+    float r, g, b;
+};
+
+// Compact terrain vertex (8 bytes instead of 36). X/Z are not stored: the vertex shader
+// rebuilds them from the vertex index, since chunk vertices are a regular grid followed by
+// the skirts (see buildTerrainChunk). Height is quantized to 16 bits over the chunk's own
+// range, the normal is octahedral-encoded in two bytes and the colour is RGB8.
+struct TerrainCompactVertex {
+    uint16_t height;
+    int8_t normal[2];
+    uint8_t color[3];
+    uint8_t pad;
+};
+static_assert(sizeof(TerrainCompactVertex) == 8, "compact terrain vertex must stay 8 bytes");
+
+// What the vertex shader needs to place a compact chunk's vertices. Grid vertex i, j (row
+// j * dim + i) sits at (originX + i * step, originZ + j * step); skirt vertices repeat the
+// edge vertices of the grid, dim per edge, and are lowered by skirtDepth. Heights decode as
+// heightOffset + height / 65535 * heightScale.
+struct TerrainCompactPlacement {
+    float originX = 0.0f, originZ = 0.0f;
+    float step = 1.0f;
+    float heightOffset = 0.0f, heightScale = 0.0f;
+    float skirtDepth = 0.0f;
+    int dim = 0;
+};
+
+// Index buffer shared by every terrain chunk (all chunks use the same grid topology)
+class TerrainIndexBuffer {
+public:
+    void Upload(const std::vector<GLuint>& indices);
+    void Release();
+
+    GLuint Handle() const { return m_IBO; }
+    GLsizei Count() const { return m_Count; }
+
+private:
+    GLuint m_IBO = 0;
+    GLsizei m_Count = 0;
+};
+
+// Retained GPU vertex buffer for one terrain chunk, in either vertex format. Chunks are
+// drawn in a batch of one format: BeginDraw binds the shared indices and vertex state once,
+// Draw issues one indexed call. GL objects are released explicitly (not in a destructor) so
+// static instances do not touch GL after the context is gone.
+class TerrainMesh {
+public:
+    // Upload (or re-upload) the vertices, reusing the existing buffer when possible
+    void Upload(const std::vector<TerrainVertex>& vertices);
+    void UploadCompact(const std::vector<TerrainCompactVertex>& vertices, const TerrainCompactPlacement& placement);
+    void Draw(const TerrainIndexBuffer& indices) const;
+    void Release();
+
+    bool IsUploaded() const { return m_VBO != 0; }
+    bool IsCompact() const { return m_Compact; }
+    size_t GpuBytes() const { return m_Bytes; }
+
+    // True once the compact format's shader is built; needs GL 3.0 (GLSL 1.30, gl_VertexID).
+    // The first call compiles it, so call it on the render thread.
+    static bool CompactSupported();
+
+    static void BeginDraw(const TerrainIndexBuffer& indices, bool compact);
+    static void EndDraw(bool compact);
+
+private:
+    GLuint m_VBO = 0;
+    size_t m_Bytes = 0;
+    bool m_Compact = false;
+    TerrainCompactPlacement m_Placement;
+};
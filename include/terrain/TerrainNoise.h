@@ -0,0 +1,120 @@
+#pragma once
+
+// Seeded 2D noise over SIMD lanes (see Simd.h): value and simplex noise, fBm and ridged
+// sums, and domain warping. Lattice corners are hashed arithmetically instead of through a
+// permutation table, so every lane runs the same integer ops and nothing needs a gather.
+// The templates are instantiated with float for scalar queries and with f4/f8/f16 inside
+// the batched height kernel, so both paths compute the same values.
+
+#include "../terrain.h"
+#include "Simd.h"
+
+namespace simd {
+
+// Scales the simplex sum to about [-1, 1] for the (1, 2) gradient set below
+const float SIMPLEX_SCALE = 45.0f;
+
+// Avalanching hash of a lattice point; the top bits are the best mixed
+template<class V>
+SIMD_INLINE UIntOf<V> noiseHash(UIntOf<V> i, UIntOf<V> j, uint32_t seed) {
+    UIntOf<V> h = (i * 501125321u) ^ (j * 1136930381u) ^ seed;
+    h *= 0x27d4eb2du;
+    h ^= h >> 15;
+    h *= 0x85ebca6bu;
+    return h ^ (h >> 13);
+}
+
+// Hash to [-1, 1]
+template<class V>
+SIMD_INLINE V hashToUnit(UIntOf<V> h) {
+    return toFloat<V>(asInt<V>(h >> 8)) * (2.0f / 16777215.0f) - 1.0f;
+}
+
+template<class V>
+SIMD_INLINE V valueNoise(V x, V z, uint32_t seed) {
+    V fx = vfloor(x), fz = vfloor(z);
+    UIntOf<V> i = asUInt<V>(toInt<V>(fx)), j = asUInt<V>(toInt<V>(fz));
+    V tx = x - fx, tz = z - fz;
+    // Quintic fade so the surface has continuous slope and curvature across cells
+    V ux = tx * tx * tx * (tx * (tx * 6.0f - 15.0f) + 10.0f);
+    V uz = tz * tz * tz * (tz * (tz * 6.0f - 15.0f) + 10.0f);
+    V v00 = hashToUnit<V>(noiseHash<V>(i, j, seed));
+    V v10 = hashToUnit<V>(noiseHash<V>(i + 1u, j, seed));
+    V v01 = hashToUnit<V>(noiseHash<V>(i, j + 1u, seed));
+    V v11 = hashToUnit<V>(noiseHash<V>(i + 1u, j + 1u, seed));
+    V a = v00 + (v10 - v00) * ux;
+    V b = v01 + (v11 - v01) * ux;
+    return a + (b - a) * uz;
+}
+
+// Contribution of one simplex corner at offset (x, z); the gradient is one of the eight
+// (+-1, +-2) / (+-2, +-1) directions picked by the hash
+template<class V>
+SIMD_INLINE V simplexCorner(V x, V z, UIntOf<V> h) {
+    UIntOf<V> g = h >> 29;
+    V u = (g & 4u) != 0u ? z : x;
+    V v = (g & 4u) != 0u ? x : z;
+    u = (g & 1u) != 0u ? -u : u;
+    v = (g & 2u) != 0u ? -v : v;
+    V t = vmax(0.5f - x * x - z * z, V{});
+    t = t * t;
+    return t * t * (u + 2.0f * v);
+}
+
+template<class V>
+SIMD_INLINE V simplexNoise(V x, V z, uint32_t seed) {
+    const float F2 = 0.366025403784f; // (sqrt(3) - 1) / 2
+    const float G2 = 0.211324865405f; // (3 - sqrt(3)) / 6
+    // Skew to the triangle lattice and find the containing simplex
+    V s = (x + z) * F2;
+    V fi = vfloor(x + s), fj = vfloor(z + s);
+    V t = (fi + fj) * G2;
+    V x0 = x - (fi - t), z0 = z - (fj - t);
+    V i1 = x0 > z0 ? V{} + 1.0f : V{};
+    V j1 = 1.0f - i1;
+    V x1 = x0 - i1 + G2, z1 = z0 - j1 + G2;
+    V x2 = x0 - (1.0f - 2.0f * G2), z2 = z0 - (1.0f - 2.0f * G2);
+
+    UIntOf<V> i = asUInt<V>(toInt<V>(fi)), j = asUInt<V>(toInt<V>(fj));
+    UIntOf<V> di = asUInt<V>(toInt<V>(i1)), dj = 1u - di;
+    V n = simplexCorner<V>(x0, z0, noiseHash<V>(i, j, seed))
+        + simplexCorner<V>(x1, z1, noiseHash<V>(i + di, j + dj, seed))
+        + simplexCorner<V>(x2, z2, noiseHash<V>(i + 1u, j + 1u, seed));
+    return n * SIMPLEX_SCALE;
+}
+
+template<class V>
+SIMD_INLINE V noise2(V x, V z, uint32_t seed, bool simplex) {
+    return simplex ? simplexNoise<V>(x, z, seed) : valueNoise<V>(x, z, seed);
+}
+
+// Height of the TerrainNoise surface at (x, z)
+template<class V>
+SIMD_INLINE V terrainNoiseLanes(V x, V z, const TerrainNoise& n) {
+    uint32_t seed = n.seed;
+    if (n.warpStrength != 0.0f) {
+        // Two decorrelated fields (distinct seeds, offset origin) displace the lookup
+        V wx = x * n.warpFrequency, wz = z * n.warpFrequency;
+        V dx = noise2<V>(wx, wz, seed ^ 0x68bc21ebu, n.simplex);
+        V dz = noise2<V>(wx + 5.2f, wz + 1.3f, seed ^ 0x02e5be93u, n.simplex);
+        x = x + dx * n.warpStrength;
+        z = z + dz * n.warpStrength;
+    }
+
+    V sum = V{};
+    float freq = n.frequency, amp = 1.0f, total = 0.0f;
+    for (int o = 0; o < n.octaves; ++o) {
+        V v = noise2<V>(x * freq, z * freq, seed + (uint32_t)o * 0x9e3779b9u, n.simplex);
+        if (n.ridged) {
+            v = 1.0f - vabs(v);
+            v = v * v;
+        }
+        sum += v * amp;
+        total += amp;
+        freq *= n.lacunarity;
+        amp *= n.gain;
+    }
+    return total > 0.0f ? sum * (n.amplitude / total) : sum;
+}
+
+} // namespace simd
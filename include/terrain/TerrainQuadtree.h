@@ -0,0 +1,136 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "TerrainMesh.h"
+#include "../terrain.h"
+#include "../camera/Frustum.h"
+
+// Identifies one quadtree node. Level 0 nodes are the finest (leaf) chunks; a node at level L
+// covers (chunkQuads << L) quads per side, sampled every (1 << L) quads. x/z count nodes of
+// that level from the central tile's minimum corner, so the roots (level == layout.levels)
+// are tile coordinates and may be negative.
+struct TerrainChunkKey {
+    int level;
+    int x;
+    int z;
+
+    bool operator<(const TerrainChunkKey& o) const {
+        if (level != o.level) return level < o.level;
+        if (x != o.x) return x < o.x;
+        return z < o.z;
+    }
+};
+
+// CPU-side mesh of one chunk: (chunkQuads+1)^2 grid vertices followed by four skirts, as
+// float vertices or, once packed, compact ones
+struct TerrainChunkData {
+    std::vector<TerrainVertex> vertices;
+    std::vector<TerrainCompactVertex> compact;
+    TerrainCompactPlacement placement;
+    float minY = 0.0f;
+    float maxY = 0.0f;
+    float skirtDepth = 0.0f;
+};
+
+// Builds the vertices of one chunk from the terrain height function. Skirts hang below every
+// chunk edge so neighbours at different resolutions never show cracks. Safe to run on a
+// worker thread, where it reads the published terrain snapshot (terrainPublish).
+void buildTerrainChunk(const TerrainLayout& layout, const TerrainChunkKey& key, TerrainChunkData& out);
+
+// Converts a built chunk to the compact format (see TerrainCompactVertex), replacing its
+// float vertices
+void packTerrainChunk(const TerrainLayout& layout, const TerrainChunkKey& key, TerrainChunkData& data);
+
+// Triangle indices for a chunk grid with skirts; identical for every chunk of a layout
+std::vector<GLuint> buildTerrainChunkIndices(int chunkQuads);
+
+// Chunked terrain renderer. Each frame the tiles around the focus are refined around the
+// eye: a node is split while the eye is closer than lodDistanceFactor times the node's
+// width, and is drawn as a single chunk otherwise. Missing chunks (roots included) and
+// chunks overlapped by an edit are meshed on the shared ThreadPool (coarse levels first)
+// and uploaded on the render thread once finished; a node keeps drawing until all four
+// children are ready, so refinement never leaves holes and the frame never waits on a build. Chunks are released
+// least recently drawn first once their meshes exceed the memory budget. Given a frustum,
+// nodes whose bounds lie outside it are neither drawn nor refined.
+class TerrainQuadtree {
+public:
+    void Draw(const glm::vec3& eye, const glm::vec3& focus, const Frustum* frustum = nullptr);
+    // Releases every chunk and the shared index buffer. Builds still running are not
+    // waited for; their results are dropped.
+    void Clear();
+
+    void SetLodDistanceFactor(float f) { m_LodDistanceFactor = f; }
+    void SetMaxBuildsInFlight(int n) { m_MaxBuildsInFlight = n; }
+    void SetRingRadius(int tiles) { m_RingRadius = tiles < 0 ? 0 : tiles; }
+    void SetMemoryBudget(size_t bytes) { m_MemoryBudget = bytes; }
+    // Takes effect on the next Draw, which rebuilds every chunk in the new format. Falls back
+    // to float vertices where the compact shader is unavailable.
+    void SetCompactVertices(bool compact) { m_WantCompact = compact; }
+
+    size_t ResidentChunks() const { return m_Chunks.size(); }
+    size_t DrawnChunks() const { return m_DrawList.size(); }
+    size_t CulledChunks() const { return m_CulledChunks; }
+    size_t PendingBuilds() const { return m_InFlight.size(); }
+    TerrainResidencyStats Stats() const;
+
+private:
+    struct Chunk {
+        TerrainMesh mesh;
+        float minY = 0.0f;
+        float maxY = 0.0f;
+        unsigned revision = 0;
+        unsigned lastUsedFrame = 0;
+    };
+
+    // Finished worker output, handed to the render thread for upload
+    struct BuildResult {
+        TerrainChunkKey key;
+        unsigned revision;
+        TerrainChunkData data;
+    };
+    // Shared with in-flight tasks so they never outlive the queue they write to
+    struct BuildQueue {
+        std::mutex mutex;
+        std::vector<BuildResult> done;
+    };
+
+    void selectTile(int tx, int tz, const glm::vec3& eye, const Frustum* frustum);
+    void selectNode(const TerrainChunkKey& key, const glm::vec3& eye, const Frustum* frustum);
+    bool nodeVisible(const TerrainChunkKey& key, const Chunk* chunk, const Frustum& frustum) const;
+    bool chunkEdited(const TerrainChunkKey& key, unsigned revision) const;
+    bool shouldSplit(const TerrainChunkKey& key, const Chunk* chunk, const glm::vec3& eye) const;
+    float distanceToNode(const TerrainChunkKey& key, const Chunk* chunk, const glm::vec3& eye) const;
+    void submitBuild(const TerrainChunkKey& key);
+    void uploadFinished();
+    void storeChunk(const TerrainChunkKey& key, unsigned revision, const TerrainChunkData& data);
+    void evictOverBudget();
+
+    TerrainLayout m_Layout;
+    bool m_HasLayout = false;
+    bool m_Compact = false; // format of the resident chunks
+    TerrainIndexBuffer m_Indices;
+    std::map<TerrainChunkKey, Chunk> m_Chunks;
+    std::vector<const Chunk*> m_DrawList;
+    size_t m_CulledChunks = 0;
+    std::vector<TerrainChunkKey> m_Requests;
+    std::set<TerrainChunkKey> m_InFlight;
+    std::shared_ptr<BuildQueue> m_Queue = std::make_shared<BuildQueue>();
+    unsigned m_Frame = 0;
+    size_t m_ResidentBytes = 0;
+    size_t m_RingTiles = 0;
+    size_t m_ResidentTiles = 0;
+    unsigned long long m_ChunksBuilt = 0;
+    unsigned long long m_ChunksEvicted = 0;
+
+    float m_LodDistanceFactor = 1.25f;
+    int m_MaxBuildsInFlight = 16;
+    int m_RingRadius = 2;
+    size_t m_MemoryBudget = (size_t)64 << 20;
+    bool m_WantCompact = true;
+};
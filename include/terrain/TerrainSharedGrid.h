@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Row-major float grid stored as bands of rows, each band shared between copies of the
+// grid. Copying a grid copies band and row pointers; MutableRow first copies the row's band
+// if another grid still holds it (copy-on-write). So an edit copies only the bands it
+// touches, and copies taken before it keep seeing the old rows.
+//
+// The thread that writes a grid is the only one that may copy it or call MutableRow; other
+// threads may read Row from copies at the same time.
+class TerrainSharedGrid {
+public:
+    // Drops every band and sets up a width x height grid of zeros
+    void Reset(int width, int height);
+    void Clear();
+    bool Empty() const { return m_Rows.empty(); }
+    int Width() const { return m_Width; }
+    int Height() const { return m_Height; }
+
+    const float* Row(int j) const { return m_Rows[(size_t)j]; }
+    // Row j for writing, unshared first if needed
+    float* MutableRow(int j);
+
+    // Copies the whole grid out, row-major
+    void CopyTo(float* out) const;
+
+private:
+    static constexpr int BAND_SHIFT = 4;
+    static constexpr int BAND_ROWS = 1 << BAND_SHIFT;
+
+    std::vector<std::shared_ptr<std::vector<float>>> m_Bands;
+    // Start of every row inside its band, so reads take one load
+    std::vector<float*> m_Rows;
+    int m_Width = 0;
+    int m_Height = 0;
+};
@@ -1,5 +1,6 @@
 ﻿#include "../../include/camera/Camera.h"
 #include "../../include/objects/MovableObject.h"
+#include "../../include/terrain.h"
 #include <algorithm>
 #include <cmath>
 
@@ -39,7 +40,13 @@ void Camera::Update() {
     float y = m_Distance * std::sin(pitchRad);
     float z = m_Distance * std::cos(pitchRad) * std::cos(yawRad);
 
-    m_Position = targetPos + glm::vec3(x, y, z);
+    // Pull the camera in front of any terrain between it and the target, so the orbit never
+    // ends up inside a mountain, then keep it off the ground
+    glm::vec3 dir = glm::vec3(x, y, z) / m_Distance;
+    float dist = m_Distance, hit;
+    if (terrainRaycast(targetPos, dir, m_Distance, hit)) dist = std::max(hit - m_TerrainClearance, 0.1f);
+    m_Position = targetPos + dir * dist;
+    m_Position.y = std::max(m_Position.y, getTerrainHeight(m_Position.x, m_Position.z) + m_TerrainClearance);
     m_LookAt   = targetPos;
     updateVectors();
 }
@@ -0,0 +1,31 @@
+#include "../../include/camera/Frustum.h"
+
+Frustum::Frustum(const glm::mat4& m) {
+    // Gribb/Hartmann: each clip-space bound -w <= x, y, z <= w is a plane in world space,
+    // made of the fourth row of the matrix plus or minus one of the others
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    m_Planes[0] = row[3] + row[0];
+    m_Planes[1] = row[3] - row[0];
+    m_Planes[2] = row[3] + row[1];
+    m_Planes[3] = row[3] - row[1];
+    m_Planes[4] = row[3] + row[2];
+    m_Planes[5] = row[3] - row[2];
+    for (auto& p : m_Planes) p /= glm::length(glm::vec3(p));
+}
+
+bool Frustum::IntersectsBox(const glm::vec3& lo, const glm::vec3& hi) const {
+    for (const auto& p : m_Planes) {
+        // The box corner furthest along the plane normal; if even it is behind, all are
+        glm::vec3 v(p.x >= 0.0f ? hi.x : lo.x, p.y >= 0.0f ? hi.y : lo.y, p.z >= 0.0f ? hi.z : lo.z);
+        if (glm::dot(glm::vec3(p), v) + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& p : m_Planes) {
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+    }
+    return true;
+}
@@ -1,9 +1,10 @@
 #include "../../include/city/City.h"
 #include "../../include/objects.h"
+#include "../../include/city/RoadIndex.h"
 #include <random>
 #include <cmath>
 
-static std::mt19937_64 rng(123456);
+static std::mt19937_64 rng(CITY_RNG_SEED);
 
 void clearCity() {
     clearBuildings();
@@ -13,6 +14,7 @@ void generateCity(int nHouses, float areaRadius, const glm::vec2 &lakeCenter) {
     clearCity();
     // first create five main roads (store locally so we can test placement)
     clearRoads();
+    clearTrees();
     
     // Define lake location away from center
     glm::vec2 lakePos(-25.0f, 25.0f);  // Top-left corner area
@@ -29,22 +31,6 @@ void generateCity(int nHouses, float areaRadius, const glm::vec2 &lakeCenter) {
     Road r7; r7.halfWidth = 2.0f; r7.pts.push_back(glm::vec2(-areaRadius*0.5f, areaRadius*0.5f)); r7.pts.push_back(glm::vec2(areaRadius*0.5f, -areaRadius*0.5f)); mainRoads.push_back(r7);
     for (const auto &mr : mainRoads) addRoad(mr);
 
-    // helper: distance from point p to segment ab
-    auto pointSegDist = [](const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b) {
-        glm::vec2 v = b - a;
-        glm::vec2 w = p - a;
-        auto dot = [](const glm::vec2 &u, const glm::vec2 &v){ return u.x * v.x + u.y * v.y; };
-        auto len = [](const glm::vec2 &u){ return std::sqrt(u.x*u.x + u.y*u.y); };
-        float c1 = dot(w, v);
-        if (c1 <= 0.0f) return len(p - a);
-        float c2 = dot(v, v);
-        if (c2 <= 0.0f) return len(p - a);
-        float t = c1 / c2;
-        if (t < 0.0f) t = 0.0f; else if (t > 1.0f) t = 1.0f;
-        glm::vec2 proj = a + v * t;
-        return len(p - proj);
-    };
-
     // Now place buildings in positions that don't overlap any main road
     std::uniform_real_distribution<float> angDist(0.0f, 2.0f * 3.14159265f);
     std::normal_distribution<float> radDist(0.0f, areaRadius / 3.0f);
@@ -77,15 +63,8 @@ void generateCity(int nHouses, float areaRadius, const glm::vec2 &lakeCenter) {
         float distToLake = std::sqrt((x - lakePos.x)*(x - lakePos.x) + (z - lakePos.y)*(z - lakePos.y));
         if (distToLake < lakeRad + 5.0f) continue;  // 5 units buffer around lake
         
-        bool ok = true;
-        for (const auto &mr : mainRoads) {
-            for (size_t i = 1; i < mr.pts.size(); ++i) {
-                float dist = pointSegDist(p, mr.pts[i-1], mr.pts[i]);
-                if (dist <= (mr.halfWidth + halfExtent + safetyMargin)) { ok = false; break; }
-            }
-            if (!ok) break;
-        }
-        if (!ok) continue;
+        // keep clear of every road added above
+        if (getRoadIndex().NearSurface(p, halfExtent + safetyMargin)) continue;
 
         glm::vec3 wc(0.95f, 0.9f, 0.55f);
         BuildingDef b{ x, z, bw, bh, bd, wc };
@@ -112,4 +91,7 @@ void generateCity(int nHouses, float areaRadius, const glm::vec2 &lakeCenter) {
             }
         }
     }
+
+    // Roadside vegetation, once every road and the lake basin are in
+    plantRoadsideTrees();
 }
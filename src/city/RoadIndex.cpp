@@ -0,0 +1,108 @@
+#include "../../include/city/RoadIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+RoadIndex::RoadIndex(float cellSize) : m_Grid(cellSize) {}
+
+void RoadIndex::Clear() {
+    m_Grid.Clear();
+    m_Segments.clear();
+    m_MaxHalfWidth = 0.0f;
+}
+
+void RoadIndex::AddRoad(uint32_t id, const Road& road) {
+    const float cell = m_Grid.CellSize();
+    auto coord = [cell](float v) { return (int)std::floor(v / cell); };
+    std::vector<std::pair<int, int>> cells;
+    for (size_t i = 1; i < road.pts.size(); ++i) {
+        Segment s{ road.pts[i-1], road.pts[i], id, (uint32_t)(i - 1), road.halfWidth };
+        if (m_Segments.empty()) m_Min = m_Max = s.a;
+        m_Min = glm::min(m_Min, glm::min(s.a, s.b));
+        m_Max = glm::max(m_Max, glm::max(s.a, s.b));
+        m_MaxHalfWidth = std::max(m_MaxHalfWidth, s.halfWidth);
+
+        // Cells the segment passes through: the boxes of pieces at most half a cell long
+        // cover them without sweeping the whole bounding box of a long diagonal
+        cells.clear();
+        glm::vec2 d = s.b - s.a;
+        int pieces = std::max(1, (int)std::ceil(glm::length(d) / (cell * 0.5f)));
+        for (int k = 0; k < pieces; ++k) {
+            glm::vec2 p0 = s.a + d * ((float)k / pieces), p1 = s.a + d * ((float)(k + 1) / pieces);
+            for (int cz = coord(std::min(p0.y, p1.y)); cz <= coord(std::max(p0.y, p1.y)); ++cz)
+                for (int cx = coord(std::min(p0.x, p1.x)); cx <= coord(std::max(p0.x, p1.x)); ++cx)
+                    cells.push_back({ cx, cz });
+        }
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+        uint32_t segId = (uint32_t)m_Segments.size();
+        for (const auto& c : cells) {
+            float x = (c.first + 0.5f) * cell, z = (c.second + 0.5f) * cell;
+            m_Grid.Insert(segId, x, z, x, z);
+        }
+        m_Segments.push_back(s);
+    }
+}
+
+RoadHit RoadIndex::measure(uint32_t id, const glm::vec2& p) const {
+    const Segment& s = m_Segments[id];
+    glm::vec2 v = s.b - s.a;
+    float len2 = glm::dot(v, v);
+    float t = len2 > 0.0f ? glm::clamp(glm::dot(p - s.a, v) / len2, 0.0f, 1.0f) : 0.0f;
+    RoadHit hit;
+    hit.found = true;
+    hit.road = s.road;
+    hit.segment = s.index;
+    hit.halfWidth = s.halfWidth;
+    hit.point = s.a + v * t;
+    hit.distance = glm::length(p - hit.point);
+    return hit;
+}
+
+const std::vector<uint32_t>& RoadIndex::candidates(const glm::vec2& p, float r) const {
+    static thread_local std::vector<uint32_t> ids;
+    ids.clear();
+    // Clamped to the indexed area, which also keeps huge radii out of cell arithmetic
+    float minX = std::max(p.x - r, m_Min.x), maxX = std::min(p.x + r, m_Max.x);
+    float minZ = std::max(p.y - r, m_Min.y), maxZ = std::min(p.y + r, m_Max.y);
+    if (!m_Segments.empty() && minX <= maxX && minZ <= maxZ) m_Grid.Query(minX, minZ, maxX, maxZ, ids);
+    return ids;
+}
+
+RoadHit RoadIndex::Nearest(const glm::vec2& p, float maxDistance) const {
+    RoadHit best;
+    if (m_Segments.empty()) return best;
+    // Past this reach the query square holds every segment
+    glm::vec2 far = glm::max(glm::abs(p - m_Min), glm::abs(p - m_Max));
+    const float whole = std::max(far.x, far.y);
+    // Grow a square around p until the best hit lies inside it: anything closer would
+    // pass through the square too
+    for (float reach = m_Grid.CellSize();; reach *= 2.0f) {
+        reach = std::min(reach, maxDistance);
+        for (uint32_t id : candidates(p, reach)) {
+            RoadHit hit = measure(id, p);
+            if (hit.distance <= maxDistance && (!best.found || hit.distance < best.distance)) best = hit;
+        }
+        if ((best.found && best.distance <= reach) || reach >= maxDistance || reach >= whole) return best;
+    }
+}
+
+float RoadIndex::Distance(const glm::vec2& p, float maxDistance) const {
+    RoadHit hit = Nearest(p, maxDistance);
+    return hit.found ? hit.distance : maxDistance;
+}
+
+void RoadIndex::WithinRadius(const glm::vec2& p, float radius, std::vector<RoadHit>& out) const {
+    for (uint32_t id : candidates(p, radius)) {
+        RoadHit hit = measure(id, p);
+        if (hit.distance <= radius) out.push_back(hit);
+    }
+}
+
+bool RoadIndex::NearSurface(const glm::vec2& p, float clearance) const {
+    for (uint32_t id : candidates(p, m_MaxHalfWidth + clearance)) {
+        RoadHit hit = measure(id, p);
+        if (hit.distance <= hit.halfWidth + clearance) return true;
+    }
+    return false;
+}
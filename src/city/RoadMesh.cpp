@@ -0,0 +1,165 @@
+#include "../../include/city/RoadMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+struct RoadColor { uint8_t r, g, b; };
+
+static const RoadColor ROAD_ASPHALT = { 51, 52, 56 };
+static const RoadColor ROAD_CONCRETE = { 194, 194, 189 };
+static const RoadColor ROAD_MARKING = { 255, 255, 255 };
+static const RoadColor ROAD_CURB = { 230, 230, 230 };
+
+static RoadVertex roadVertex(const glm::vec3& p, RoadColor c) {
+    return RoadVertex{ p.x, p.y, p.z, c.r, c.g, c.b, 255 };
+}
+
+static void addTriangle(std::vector<RoadVertex>& out, const glm::vec3& a, const glm::vec3& b,
+                        const glm::vec3& c, RoadColor color) {
+    out.push_back(roadVertex(a, color));
+    out.push_back(roadVertex(b, color));
+    out.push_back(roadVertex(c, color));
+}
+
+static void addQuad(std::vector<RoadVertex>& out, const glm::vec3& a0, const glm::vec3& b0,
+                    const glm::vec3& a1, const glm::vec3& b1, RoadColor color) {
+    addTriangle(out, a0, b0, a1, color);
+    addTriangle(out, b0, b1, a1, color);
+}
+
+void bakeRoadGeometry(const Road& road, const std::vector<glm::vec3>& samples,
+                      const std::vector<std::vector<glm::vec3>>& caps, float sidewalkWidth, RoadGeometry& out) {
+    out.triangles.clear();
+    out.lines.clear();
+    const size_t n = samples.size();
+    if (n < 2) return;
+
+    // Sideways direction at each sample, from its neighbours
+    std::vector<glm::vec3> side(n);
+    for (size_t i = 0; i < n; ++i) {
+        glm::vec3 v = samples[i + 1 < n ? i + 1 : i] - samples[i > 0 ? i - 1 : i];
+        float l = glm::length(v);
+        glm::vec3 tangent = l < 1e-5f ? glm::vec3(1.0f, 0.0f, 0.0f) : v / l;
+        side[i] = glm::vec3(-tangent.z, 0.0f, tangent.x);
+    }
+    // Band between offsets a and b from the centreline, lifted by lift
+    auto band = [&](float a, float b, float lift, RoadColor color) {
+        const glm::vec3 up(0.0f, lift, 0.0f);
+        for (size_t i = 1; i < n; ++i) {
+            addQuad(out.triangles, samples[i-1] + side[i-1] * a + up, samples[i-1] + side[i-1] * b + up,
+                    samples[i] + side[i] * a + up, samples[i] + side[i] * b + up, color);
+        }
+    };
+
+    const float hw = road.halfWidth;
+    band(hw, -hw, 0.0f, ROAD_ASPHALT);
+    band(hw + sidewalkWidth, hw, 0.005f, ROAD_CONCRETE);
+    band(-hw, -(hw + sidewalkWidth), 0.005f, ROAD_CONCRETE);
+
+    if (road.isMain) {
+        // solid centre line
+        band(0.2f, -0.2f, 0.02f, ROAD_MARKING);
+    } else {
+        // dashes restart on every sample segment
+        const float dashLen = 0.8f, dashGap = 0.6f, half = 0.06f;
+        for (size_t i = 1; i < n; ++i) {
+            glm::vec3 diff = samples[i] - samples[i-1];
+            float seg = glm::length(diff);
+            if (seg < 1e-6f) continue;
+            glm::vec3 dir = diff / seg;
+            glm::vec3 across = glm::vec3(-dir.z, 0.0f, dir.x) * half;
+            glm::vec3 lift(0.0f, 0.02f, 0.0f);
+            for (float t = 0.0f; t < seg; t += dashLen + dashGap) {
+                glm::vec3 p0 = samples[i-1] + dir * t + lift;
+                glm::vec3 p1 = samples[i-1] + dir * std::min(t + dashLen, seg) + lift;
+                addQuad(out.triangles, p0 - across, p0 + across, p1 - across, p1 + across, ROAD_MARKING);
+            }
+        }
+    }
+
+    // intersection caps: asphalt, then a slightly larger concrete skirt
+    for (size_t ci = 0; ci < caps.size(); ++ci) {
+        const auto& fan = caps[ci];
+        RoadColor color = (ci % 2 == 0) ? ROAD_ASPHALT : ROAD_CONCRETE;
+        for (size_t k = 2; k < fan.size(); ++k) addTriangle(out.triangles, fan[0], fan[k-1], fan[k], color);
+    }
+
+    // curbs just outside the carriageway
+    const glm::vec3 curbLift(0.0f, 0.03f, 0.0f);
+    for (float s : { 1.0f, -1.0f }) {
+        float offset = s * (hw + 0.01f);
+        for (size_t i = 1; i < n; ++i) {
+            out.lines.push_back(roadVertex(samples[i-1] + side[i-1] * offset + curbLift, ROAD_CURB));
+            out.lines.push_back(roadVertex(samples[i] + side[i] * offset + curbLift, ROAD_CURB));
+        }
+    }
+}
+
+void RoadMesh::SetRoad(size_t index, const RoadGeometry& geometry) {
+    if (index >= m_Roads.size()) m_Roads.resize(index + 1);
+    m_Roads[index] = geometry;
+    m_Dirty = true;
+}
+
+void RoadMesh::Clear() {
+    m_Roads.clear();
+    m_Dirty = true;
+}
+
+void RoadMesh::upload() {
+    m_Dirty = false;
+    // Every road's triangles first, then every road's lines
+    std::vector<RoadVertex> vertices;
+    m_TriangleRanges.assign(m_Roads.size(), Range());
+    m_LineRanges.assign(m_Roads.size(), Range());
+    for (size_t i = 0; i < m_Roads.size(); ++i) {
+        const auto& tris = m_Roads[i].triangles;
+        m_TriangleRanges[i] = Range{ (GLint)vertices.size(), (GLsizei)tris.size() };
+        vertices.insert(vertices.end(), tris.begin(), tris.end());
+    }
+    for (size_t i = 0; i < m_Roads.size(); ++i) {
+        const auto& lines = m_Roads[i].lines;
+        m_LineRanges[i] = Range{ (GLint)vertices.size(), (GLsizei)lines.size() };
+        vertices.insert(vertices.end(), lines.begin(), lines.end());
+    }
+    m_Bytes = vertices.size() * sizeof(RoadVertex);
+    if (!m_VBO) glGenBuffers(1, &m_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, m_Bytes, vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RoadMesh::multiDraw(GLenum mode, const std::vector<Range>& ranges, const std::vector<uint32_t>& roads) {
+    m_First.clear();
+    m_Count.clear();
+    for (uint32_t r : roads) {
+        if (r >= ranges.size() || !ranges[r].count) continue;
+        m_First.push_back(ranges[r].first);
+        m_Count.push_back(ranges[r].count);
+    }
+    if (!m_First.empty()) glMultiDrawArrays(mode, m_First.data(), m_Count.data(), (GLsizei)m_First.size());
+}
+
+void RoadMesh::Draw(const std::vector<uint32_t>& roads) {
+    if (m_Dirty) upload();
+    if (!m_Bytes || roads.empty()) return;
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RoadVertex), (const void*)offsetof(RoadVertex, x));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(RoadVertex), (const void*)offsetof(RoadVertex, r));
+    multiDraw(GL_TRIANGLES, m_TriangleRanges, roads);
+    glLineWidth(2.0f);
+    multiDraw(GL_LINES, m_LineRanges, roads);
+    glLineWidth(1.0f);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RoadMesh::Release() {
+    if (m_VBO) glDeleteBuffers(1, &m_VBO);
+    m_VBO = 0;
+    m_Bytes = 0;
+    m_Dirty = !m_Roads.empty();
+}
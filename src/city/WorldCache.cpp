@@ -0,0 +1,187 @@
+#include "../../include/city/WorldCache.h"
+#include "../../include/objects.h"
+#include "../../include/terrain.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/stat.h>
+
+static const char WORLD_MAGIC[8] = { 'T', 'E', 'R', 'R', 'W', 'R', 'L', 'D' };
+static const uint32_t WORLD_VERSION = 2;
+
+struct WorldCacheHeader {
+    char magic[8];       // "TERRWRLD"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t key;
+    double generationMs; // time the cold start spent generating this world
+};
+
+static_assert(std::is_trivially_copyable<BuildingDef>::value, "buildings are stored as raw records");
+
+static std::string worldCachePath(const char* dir, uint64_t key) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/world-%016llx.bin", (unsigned long long)key);
+    return std::string(dir) + name;
+}
+
+// Appends plain records to the blob
+struct BlobWriter {
+    std::vector<unsigned char> data;
+
+    void PutBytes(const void* p, size_t n) {
+        const unsigned char* b = (const unsigned char*)p;
+        data.insert(data.end(), b, b + n);
+    }
+    template<class T> void Put(const T& v) { PutBytes(&v, sizeof(T)); }
+    template<class T> void PutArray(const std::vector<T>& v) {
+        Put((uint32_t)v.size());
+        if (!v.empty()) PutBytes(v.data(), v.size() * sizeof(T));
+    }
+};
+
+// Bounds-checked reads from the loaded blob; once anything overruns, every read fails
+struct BlobReader {
+    const unsigned char* p;
+    const unsigned char* end;
+    bool ok = true;
+
+    bool GetBytes(void* out, size_t n) {
+        if (!ok || (size_t)(end - p) < n) return ok = false;
+        std::memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    template<class T> bool Get(T& v) { return GetBytes(&v, sizeof(T)); }
+    template<class T> bool GetArray(std::vector<T>& v) {
+        uint32_t n = 0;
+        if (!Get(n) || (size_t)(end - p) / sizeof(T) < n) return ok = false;
+        v.resize(n);
+        return n == 0 || GetBytes(v.data(), (size_t)n * sizeof(T));
+    }
+};
+
+struct PondRecord { glm::vec2 center; float radius; };
+
+bool loadWorldCache(const char* dir, uint64_t key) {
+    auto start = std::chrono::steady_clock::now();
+    std::string path = worldCachePath(dir, key);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::vector<unsigned char> blob;
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? std::ftell(file) : -1;
+    ok = size > 0 && std::fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        blob.resize((size_t)size);
+        ok = std::fread(blob.data(), 1, blob.size(), file) == blob.size();
+    }
+    std::fclose(file);
+
+    // Parse everything before touching the world, so a damaged file changes nothing
+    BlobReader in{ blob.data(), blob.data() + blob.size() };
+    WorldCacheHeader h;
+    ok = ok && in.Get(h) && std::memcmp(h.magic, WORLD_MAGIC, sizeof(WORLD_MAGIC)) == 0 &&
+         h.version == WORLD_VERSION && h.key == key;
+    int32_t dim = 0;
+    float origin = 0.0f, spacing = 0.0f;
+    std::vector<float> heights;
+    ok = ok && in.Get(dim) && in.Get(origin) && in.Get(spacing) && in.GetArray(heights) &&
+         dim > 1 && heights.size() == (size_t)dim * dim;
+    uint32_t roadCount = 0;
+    std::vector<Road> roads;
+    ok = ok && in.Get(roadCount);
+    for (uint32_t i = 0; ok && i < roadCount; ++i) {
+        Road r;
+        uint32_t isMain = 0;
+        ok = in.Get(r.halfWidth) && in.Get(isMain) && in.GetArray(r.pts);
+        r.isMain = isMain != 0;
+        roads.push_back(std::move(r));
+    }
+    std::vector<BuildingDef> buildings;
+    std::vector<PondRecord> ponds;
+    std::vector<glm::vec3> lights;
+    std::vector<glm::vec2> coins;
+    std::vector<glm::vec2> trees;
+    ok = ok && in.GetArray(buildings) && in.GetArray(ponds) && in.GetArray(lights) && in.GetArray(coins) &&
+         in.GetArray(trees);
+    if (!ok) {
+        printf("Ignoring damaged world cache: %s\n", path.c_str());
+        return false;
+    }
+    // The grid goes in first so everything placed below snaps to it instead of rebuilding it.
+    // It already has the pond basins, so the ponds are restored without invalidating it.
+    if (!terrainLoadHeightCache(heights.data(), dim, origin, spacing)) {
+        printf("Ignoring world cache for a different terrain layout: %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<std::pair<glm::vec2, float>> pondList;
+    for (const auto& p : ponds) pondList.emplace_back(p.center, p.radius);
+    setPonds(pondList);
+    clearRoads();
+    for (const auto& r : roads) addRoad(r);
+    clearBuildings();
+    for (const auto& b : buildings) addBuilding(b);
+    clearStreetLights();
+    for (const auto& l : lights) addStreetLight(l);
+    setCoins(coins);
+    clearTrees();
+    for (const auto& t : trees) addTree(t);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("World loaded from cache in %.1f ms (generating it took %.1f ms, %.1f ms saved)\n",
+           ms, h.generationMs, h.generationMs - ms);
+    return true;
+}
+
+bool saveWorldCache(const char* dir, uint64_t key, double generationMs) {
+    BlobWriter out;
+    WorldCacheHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, WORLD_MAGIC, sizeof(WORLD_MAGIC));
+    h.version = WORLD_VERSION;
+    h.key = key;
+    h.generationMs = generationMs;
+    out.Put(h);
+
+    int dim = 0;
+    float origin = 0.0f, spacing = 0.0f;
+    const float* grid = terrainHeightCache(dim, origin, spacing);
+    out.Put((int32_t)dim);
+    out.Put(origin);
+    out.Put(spacing);
+    out.PutArray(std::vector<float>(grid, grid + (size_t)dim * dim));
+
+    const auto& roads = getRoads();
+    out.Put((uint32_t)roads.size());
+    for (const auto& r : roads) {
+        out.Put(r.halfWidth);
+        out.Put((uint32_t)(r.isMain ? 1 : 0));
+        out.PutArray(r.pts);
+    }
+    out.PutArray(getBuildings());
+    std::vector<PondRecord> ponds;
+    for (const auto& p : getPonds()) ponds.push_back(PondRecord{ p.first, p.second });
+    out.PutArray(ponds);
+    out.PutArray(getStreetLights());
+    out.PutArray(getCoins());
+    out.PutArray(getTrees());
+
+    // Written under a temporary name and renamed, so a crash never leaves a partial entry
+    mkdir(dir, 0755); // fails harmlessly if it exists
+    std::string path = worldCachePath(dir, key);
+    std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    bool ok = file && std::fwrite(out.data.data(), 1, out.data.size(), file) == out.data.size();
+    ok = file && (std::fclose(file) == 0) && ok;
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        printf("Failed to write world cache: %s\n", path.c_str());
+        std::remove(tmp.c_str());
+    }
+    return ok;
+}
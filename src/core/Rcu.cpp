@@ -0,0 +1,75 @@
+#include "../../include/core/Rcu.h"
+
+// One slot per reading thread, each on its own cache line so readers never contend.
+// epoch is 0 while the thread is outside any read scope.
+struct alignas(64) RcuReaderSlot {
+    std::atomic<uint64_t> epoch{ 0 };
+    std::atomic<bool> owned{ false };
+};
+
+// Blocks form a list that only grows and is never freed, so the writer can walk it while
+// threads come and go. Slots of exited threads are reused.
+struct RcuSlotBlock {
+    RcuReaderSlot slots[RCU_READER_SLOTS_PER_BLOCK];
+    std::atomic<RcuSlotBlock*> next{ nullptr };
+};
+
+static RcuSlotBlock s_firstBlock;
+static std::atomic<uint64_t> s_epoch{ 1 };
+
+// Claims a slot for the calling thread on first use and gives it back when the thread exits
+struct RcuThreadSlot {
+    RcuReaderSlot* slot = nullptr;
+    int depth = 0;
+
+    RcuThreadSlot() {
+        for (RcuSlotBlock* block = &s_firstBlock;;) {
+            for (RcuReaderSlot& s : block->slots) {
+                bool expected = false;
+                if (s.owned.compare_exchange_strong(expected, true)) {
+                    slot = &s;
+                    return;
+                }
+            }
+            RcuSlotBlock* next = block->next.load();
+            if (!next) {
+                // Every slot is taken: append a block, unless another thread just did
+                RcuSlotBlock* added = new RcuSlotBlock;
+                if (block->next.compare_exchange_strong(next, added)) next = added;
+                else delete added;
+            }
+            block = next;
+        }
+    }
+    ~RcuThreadSlot() {
+        slot->epoch.store(0);
+        slot->owned.store(false);
+    }
+};
+
+static thread_local RcuThreadSlot t_slot;
+
+// All accesses are sequentially consistent: a writer that does not see a reader's epoch
+// store has swapped the pointer before the reader loads it, so that reader gets the new copy
+RcuReadScope::RcuReadScope() {
+    if (t_slot.depth++ == 0) t_slot.slot->epoch.store(s_epoch.load());
+}
+
+RcuReadScope::~RcuReadScope() {
+    if (--t_slot.depth == 0) t_slot.slot->epoch.store(0);
+}
+
+uint64_t rcuAdvanceEpoch() {
+    return s_epoch.fetch_add(1) + 1;
+}
+
+uint64_t rcuQuiescentEpoch() {
+    uint64_t oldest = s_epoch.load() + 1;
+    for (const RcuSlotBlock* block = &s_firstBlock; block; block = block->next.load()) {
+        for (const RcuReaderSlot& s : block->slots) {
+            uint64_t e = s.epoch.load();
+            if (e != 0 && e < oldest) oldest = e;
+        }
+    }
+    return oldest;
+}
@@ -0,0 +1,66 @@
+#include "../../include/core/SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize) {
+    SetCellSize(cellSize);
+}
+
+void SpatialHash::SetCellSize(float cellSize) {
+    m_CellSize = cellSize > 0.0f ? cellSize : 1.0f;
+    m_InvCellSize = 1.0f / m_CellSize;
+    m_Cells.clear();
+}
+
+void SpatialHash::Clear() {
+    m_Cells.clear();
+}
+
+int SpatialHash::cellCoord(float v) const {
+    return (int)std::floor(v * m_InvCellSize);
+}
+
+void SpatialHash::Insert(uint32_t id, float minX, float minZ, float maxX, float maxZ) {
+    int cx0 = cellCoord(minX), cx1 = cellCoord(maxX);
+    int cz0 = cellCoord(minZ), cz1 = cellCoord(maxZ);
+    for (int cz = cz0; cz <= cz1; ++cz)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            m_Cells[cellKey(cx, cz)].push_back(id);
+}
+
+void SpatialHash::Remove(uint32_t id, float minX, float minZ, float maxX, float maxZ) {
+    int cx0 = cellCoord(minX), cx1 = cellCoord(maxX);
+    int cz0 = cellCoord(minZ), cz1 = cellCoord(maxZ);
+    for (int cz = cz0; cz <= cz1; ++cz) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            auto it = m_Cells.find(cellKey(cx, cz));
+            if (it == m_Cells.end()) continue;
+            auto& ids = it->second;
+            auto pos = std::find(ids.begin(), ids.end(), id);
+            if (pos != ids.end()) {
+                *pos = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty()) m_Cells.erase(it);
+        }
+    }
+}
+
+const std::vector<uint32_t>* SpatialHash::CellAt(float x, float z) const {
+    auto it = m_Cells.find(cellKey(cellCoord(x), cellCoord(z)));
+    return it != m_Cells.end() ? &it->second : nullptr;
+}
+
+void SpatialHash::Query(float minX, float minZ, float maxX, float maxZ, std::vector<uint32_t>& out) const {
+    size_t first = out.size();
+    int cx0 = cellCoord(minX), cx1 = cellCoord(maxX);
+    int cz0 = cellCoord(minZ), cz1 = cellCoord(maxZ);
+    for (int cz = cz0; cz <= cz1; ++cz) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            auto it = m_Cells.find(cellKey(cx, cz));
+            if (it != m_Cells.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
@@ -0,0 +1,88 @@
+#include "../../include/core/ThreadPool.h"
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        unsigned hc = std::thread::hardware_concurrency();
+        threads = std::max(1u, hc > 1 ? hc - 1 : 1u);
+    }
+    for (unsigned i = 0; i < threads; ++i)
+        m_Workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+        m_Tasks.clear();
+    }
+    m_Cond.notify_all();
+    for (auto& t : m_Workers) t.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_Cond.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return m_Stop || !m_Tasks.empty(); });
+            if (m_Stop) return;
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(int begin, int end, const std::function<void(int)>& fn) {
+    if (end <= begin) return;
+
+    // Shared with the helper tasks, which may start after the caller has already finished
+    // every iteration (workers busy with other jobs); they then find no work and exit.
+    struct State {
+        std::atomic<int> next;
+        std::atomic<int> done{0};
+        int end;
+        const std::function<void(int)>* fn;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    auto state = std::make_shared<State>();
+    state->next = begin;
+    state->end = end;
+    state->fn = &fn;
+    const int total = end - begin;
+
+    auto run = [state, total] {
+        for (;;) {
+            int i = state->next.fetch_add(1);
+            if (i >= state->end) return;
+            (*state->fn)(i);
+            if (state->done.fetch_add(1) + 1 == total) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cond.notify_all();
+            }
+        }
+    };
+
+    unsigned helpers = std::min<unsigned>(ThreadCount(), (unsigned)total - 1);
+    for (unsigned h = 0; h < helpers; ++h) Submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cond.wait(lock, [&] { return state->done.load() == total; });
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -12,12 +12,34 @@
 
 #include "../include/terrain.h"
 #include "../include/objects.h"
+#include "../include/camera/Frustum.h"
+#include "../include/city/RoadMesh.h"
+#include "../include/city/RoadIndex.h"
+#include "../include/core/SpatialHash.h"
 
 // Static texture handles for buildings (0=none, 1=brick, 2=metal)
 static GLuint g_buildingTextures[3] = {0, 0, 0};
 
 bool isPositionInsideBuilding(float x, float z, float radius);
 
+// Static props (buildings, trees, street lights, coins, roads, pond shores) keep the terrain
+// height under them from when they were placed. Every draw* entry point calls this first: it
+// re-snaps only the props that a terrain edit touched since the last call, so frames without
+// edits make no height queries at all.
+static void syncPropHeights();
+
+static PropCullStats s_cullStats;
+
+void resetPropCullStats() { s_cullStats = PropCullStats(); }
+PropCullStats getPropCullStats() { return s_cullStats; }
+
+// Whether a prop with bounds [lo, hi] has to be drawn; counts it either way
+static bool propVisible(const Frustum* frustum, const glm::vec3 &lo, const glm::vec3 &hi) {
+    bool visible = !frustum || frustum->IntersectsBox(lo, hi);
+    ++(visible ? s_cullStats.drawn : s_cullStats.culled);
+    return visible;
+}
+
 // Simple texture loader for building diffuse
 void initBuildingTexture(const std::string &path, int textureType) {
     if (textureType < 0 || textureType > 2) return;
@@ -91,8 +113,12 @@ static void drawCube(float width, float height, float depth, bool shaded = false
     glEnd();
 }
 
-static void drawTree(float x, float z) {
-    float y = getTerrainHeight(x, z);
+// Bounds of drawTree's trunk and canopy around the trunk foot
+static const glm::vec3 TREE_EXTENT_LO(-0.5f, -0.35f, -0.5f);
+static const glm::vec3 TREE_EXTENT_HI(0.5f, 1.35f, 0.5f);
+
+// y: ground height under the trunk
+static void drawTree(float x, float y, float z) {
     glPushMatrix();
     glTranslatef(x, y + 0.05f, z);
     glColor3f(0.4f, 0.25f, 0.1f);
@@ -103,41 +129,40 @@ static void drawTree(float x, float z) {
     glPopMatrix();
 }
 
+static void drawVertices(GLenum mode, const std::vector<glm::vec3> &verts) {
+    glBegin(mode);
+    for (const auto &v : verts) glVertex3f(v.x, v.y, v.z);
+    glEnd();
+}
+
 // helper: filled circular cap (triangle fan) to cover intersections
-// Draw a filled disk (triangle fan) positioned just above the local terrain to avoid being
-// occluded by nearby triangles. Use polygon offset when drawing water to reduce z-fighting.
-static void drawFilledDisk(float cx, float cz, float radius, int segments = 20) {
-    // place the water a hair above the terrain height so it can be blended on top
-    float centerY = getTerrainHeight(cx, cz) + 0.001f;
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex3f(cx, centerY, cz);
+// Snaps a filled disk (triangle fan) just above the local terrain to avoid being occluded by
+// nearby triangles. Draw the result with drawVertices(GL_TRIANGLE_FAN, ...).
+static void snapFilledDisk(std::vector<glm::vec3> &fan, float cx, float cz, float radius, int segments = 20) {
+    fan.clear();
+    // a hair above the terrain height so it can be blended on top
+    fan.push_back(glm::vec3(cx, getTerrainHeight(cx, cz) + 0.001f, cz));
     for (int i = 0; i <= segments; ++i) {
         float a = (float)i / (float)segments * 2.0f * 3.14159265f;
         float x = cx + std::cos(a) * radius;
         float z = cz + std::sin(a) * radius;
-        float yy = getTerrainHeight(x, z) + 0.001f;
-        glVertex3f(x, yy, z);
+        fan.push_back(glm::vec3(x, getTerrainHeight(x, z) + 0.001f, z));
     }
-    glEnd();
 }
 
-// Draw an annulus (ring) between innerRadius and outerRadius. This is used for the
-// shore/side band so we don't cover the full water disk with a larger filled disk.
-static void drawDiskAnnulus(float cx, float cz, float innerRadius, float outerRadius, int segments = 24) {
-    float centerY = getTerrainHeight(cx, cz) + 0.001f;
-    glBegin(GL_TRIANGLE_STRIP);
+// Snaps an annulus (ring) between innerRadius and outerRadius as a triangle strip. This is
+// used for the shore/side band so we don't cover the full water disk with a larger filled disk.
+static void snapDiskAnnulus(std::vector<glm::vec3> &strip, float cx, float cz, float innerRadius, float outerRadius, int segments = 24) {
+    strip.clear();
     for (int i = 0; i <= segments; ++i) {
         float a = (float)i / (float)segments * 2.0f * 3.14159265f;
         float ix = cx + std::cos(a) * innerRadius;
         float iz = cz + std::sin(a) * innerRadius;
         float ox = cx + std::cos(a) * outerRadius;
         float oz = cz + std::sin(a) * outerRadius;
-        float iy = getTerrainHeight(ix, iz) + 0.001f;
-        float oy = getTerrainHeight(ox, oz) + 0.001f;
-        glVertex3f(ix, iy, iz);
-        glVertex3f(ox, oy, oz);
+        strip.push_back(glm::vec3(ix, getTerrainHeight(ix, iz) + 0.001f, iz));
+        strip.push_back(glm::vec3(ox, getTerrainHeight(ox, oz) + 0.001f, oz));
     }
-    glEnd();
 }
 
 // Draw water surface with depth gradient (darker in center, lighter at edges)
@@ -181,45 +206,70 @@ static void drawWaterSurface(float cx, float cz, float radius, float baseY, int
     glLineWidth(1.0f);
 }
 
-// helper: 2D point-segment distance
-static float pointSegDist2D(const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b) {
-    glm::vec2 v = b - a;
-    glm::vec2 w = p - a;
-    float c1 = w.x * v.x + w.y * v.y;
-    if (c1 <= 0.0f) return std::sqrt((p.x - a.x)*(p.x - a.x) + (p.y - a.y)*(p.y - a.y));
-    float c2 = v.x * v.x + v.y * v.y;
-    if (c2 <= 0.0f) return std::sqrt((p.x - a.x)*(p.x - a.x) + (p.y - a.y)*(p.y - a.y));
-    float t = c1 / c2;
-    if (t < 0.0f) t = 0.0f; else if (t > 1.0f) t = 1.0f;
-    glm::vec2 proj = a + v * t;
-    return std::sqrt((p.x - proj.x)*(p.x - proj.x) + (p.y - proj.y)*(p.y - proj.y));
-}
-
 // Ponds storage
 static std::vector<std::pair<glm::vec2,float>> s_ponds;
 
-void addPond(const glm::vec2 &center, float radius) { s_ponds.emplace_back(center, radius); }
-void clearPonds() { s_ponds.clear(); }
+// Snapped pond geometry, parallel to s_ponds
+struct PondGround {
+    float centerY = 0.0f;
+    std::vector<glm::vec3> shore;   // sandy band, r * 0.95 .. r + 1.2
+    std::vector<glm::vec3> wetSand; // r * 0.92 .. r * 0.95
+    glm::vec3 lo, hi;               // shore and water surface
+};
+static std::vector<PondGround> s_pondGround;
+
+static PondGround snapPond(const glm::vec2 &c, float r) {
+    PondGround g;
+    g.centerY = getTerrainHeight(c.x, c.y);
+    snapDiskAnnulus(g.shore, c.x, c.y, r * 0.95f, r + 1.2f, 32);
+    snapDiskAnnulus(g.wetSand, c.x, c.y, r * 0.92f, r * 0.95f, 24);
+    g.lo = g.hi = glm::vec3(c.x, g.centerY + 3.5f, c.y); // water level, see drawPonds
+    for (const auto &v : g.shore) { g.lo = glm::min(g.lo, v); g.hi = glm::max(g.hi, v); }
+    return g;
+}
+
+// Ponds only reshape the terrain inside their radius
+static void invalidatePondRegion(const glm::vec2 &c, float r) { terrainInvalidateRegion(c.x - r, c.y - r, c.x + r, c.y + r); }
+
+void addPond(const glm::vec2 &center, float radius) {
+    s_ponds.emplace_back(center, radius);
+    invalidatePondRegion(center, radius);
+    // snapped after the invalidation so the shore follows the carved basin
+    s_pondGround.push_back(snapPond(center, radius));
+}
+void clearPonds() {
+    for (const auto &pp : s_ponds) invalidatePondRegion(pp.first, pp.second);
+    s_ponds.clear();
+    s_pondGround.clear();
+}
+void setPonds(const std::vector<std::pair<glm::vec2,float>> &ponds) {
+    s_ponds = ponds;
+    terrainReloadPonds();
+    s_pondGround.clear();
+    for (const auto &pp : s_ponds) s_pondGround.push_back(snapPond(pp.first, pp.second));
+}
 const std::vector<std::pair<glm::vec2,float>>& getPonds() { return s_ponds; }
 
 
 
-void drawPonds() {
-    for (const auto &pp : s_ponds) {
-        const glm::vec2 &c = pp.first;
-        float r = pp.second;
+void drawPonds(const Frustum* frustum) {
+    syncPropHeights();
+    for (size_t pi = 0; pi < s_ponds.size(); ++pi) {
+        const glm::vec2 &c = s_ponds[pi].first;
+        float r = s_ponds[pi].second;
+        const PondGround &g = s_pondGround[pi];
+        if (!propVisible(frustum, g.lo, g.hi)) continue;
         
-        // Determine base water level at pond center
-        float centerHeight = getTerrainHeight(c.x, c.y);
-        float waterY = centerHeight + 3.5f;  // Raised higher for better visibility
+        // Base water level from the ground at pond center
+        float waterY = g.centerY + 3.5f;  // Raised higher for better visibility
         
         // Draw sandy/muddy shore band (wider and more natural looking)
         glColor3f(0.72f, 0.6f, 0.42f);  // Sandy beach color
-        drawDiskAnnulus(c.x, c.y, r * 0.95f, r + 1.2f, 32);
+        drawVertices(GL_TRIANGLE_STRIP, g.shore);
         
         // Draw darker wet sand/mud transition
         glColor3f(0.45f, 0.35f, 0.25f);  // Wet sand
-        drawDiskAnnulus(c.x, c.y, r * 0.92f, r * 0.95f, 24);
+        drawVertices(GL_TRIANGLE_STRIP, g.wetSand);
         
         // Draw water surface with depth and transparency
         glEnable(GL_BLEND);
@@ -235,12 +285,20 @@ void drawPonds() {
 
 // Street lights storage
 static std::vector<glm::vec3> s_streetLights;
-void addStreetLight(const glm::vec3 &pos) { s_streetLights.push_back(pos); }
-void clearStreetLights() { s_streetLights.clear(); }
-
-void drawStreetLights() {
-    for (const auto &p : s_streetLights) {
-        float y = getTerrainHeight(p.x, p.z);
+static std::vector<float> s_streetLightGroundY; // parallel to s_streetLights
+void addStreetLight(const glm::vec3 &pos) {
+    s_streetLights.push_back(pos);
+    s_streetLightGroundY.push_back(getTerrainHeight(pos.x, pos.z));
+}
+void clearStreetLights() { s_streetLights.clear(); s_streetLightGroundY.clear(); }
+
+void drawStreetLights(const Frustum* frustum) {
+    syncPropHeights();
+    for (size_t li = 0; li < s_streetLights.size(); ++li) {
+        const glm::vec3 &p = s_streetLights[li];
+        float y = s_streetLightGroundY[li];
+        // pole, and the lamp head reaching out along +z
+        if (!propVisible(frustum, glm::vec3(p.x - 0.2f, y, p.z - 0.1f), glm::vec3(p.x + 0.2f, y + 4.3f, p.z + 0.45f))) continue;
         glPushMatrix();
         glTranslatef(p.x, y, p.z);
         // pole
@@ -274,15 +332,43 @@ void drawStreetLights() {
 
 // Storage for buildings and roads
 static std::vector<BuildingDef> s_buildings;
+// Building footprints by position in s_buildings, for isPositionInsideBuilding. Footprints
+// are a few units wide, so most queries read a single cell.
+static SpatialHash s_buildingGrid(4.0f);
 static std::vector<Road> s_roads;
 static std::vector<glm::vec2> s_trees;
+static std::vector<float> s_treeGroundY; // parallel to s_trees
+
+static const float ROAD_SAMPLE_SPACING = 0.5f;
+static const float ROAD_SIDEWALK_WIDTH = 0.45f;
+
+// Snapped road placement, parallel to s_roads; the surface itself is baked into s_roadMesh
+struct RoadGround {
+    bool hasSurface = false;
+    std::vector<glm::vec2> treeSpots; // roadside tree spots for plantRoadsideTrees
+    glm::vec3 lo{0.0f}, hi{0.0f};     // surface and caps
+};
+static std::vector<RoadGround> s_roadGround;
+static RoadMesh s_roadMesh;
+static RoadIndex s_roadIndex;
+static std::vector<uint32_t> s_visibleRoads; // reused by drawRoads
 
 static void ensureTreesInitialized();
 
-void drawTrees() {
+void addTree(const glm::vec2 &pos) {
+    s_trees.push_back(pos);
+    s_treeGroundY.push_back(getTerrainHeight(pos.x, pos.y));
+}
+
+void clearTrees() { s_trees.clear(); s_treeGroundY.clear(); }
+
+void drawTrees(const Frustum* frustum) {
     ensureTreesInitialized();
-    for (const auto &t : s_trees) {
-        drawTree(t.x, t.y);
+    syncPropHeights();
+    for (size_t ti = 0; ti < s_trees.size(); ++ti) {
+        glm::vec3 foot(s_trees[ti].x, s_treeGroundY[ti], s_trees[ti].y);
+        if (!propVisible(frustum, foot + TREE_EXTENT_LO, foot + TREE_EXTENT_HI)) continue;
+        drawTree(foot.x, foot.y, foot.z);
     }
 }
 
@@ -297,23 +383,65 @@ static void ensureTreesInitialized() {
         float distToLake = std::sqrt((pos.x - lakePos.x)*(pos.x - lakePos.x) + (pos.y - lakePos.y)*(pos.y - lakePos.y));
         if (distToLake > lakeRad + 5.0f) {
             s_trees.push_back(pos);
+            s_treeGroundY.push_back(getTerrainHeight(pos.x, pos.y));
         }
     }
 }
 
-// Coins storage (defined here where s_roads is visible)
-struct Coin { glm::vec2 p; bool collected; };
-static std::vector<Coin> s_coins;
+// Coins storage (defined here where s_roads is visible). Only uncollected coins are kept,
+// densely: a pickup swaps the last coin into its slot. s_coinGrid lists each coin under
+// its slot, so a move re-files the moved coin.
+static std::vector<glm::vec2> s_coinPos;
+static std::vector<float> s_coinGroundY;
+static std::vector<int> s_coinPhase; // bob / spin offset, fixed at spawn so moves don't show
+static SpatialHash s_coinGrid(4.0f);
+static int s_coinsTotal = 0;
+static int s_coinsCollected = 0;
+
+void clearCoins() {
+    s_coinPos.clear();
+    s_coinGroundY.clear();
+    s_coinPhase.clear();
+    s_coinGrid.Clear();
+    s_coinsTotal = 0;
+    s_coinsCollected = 0;
+}
 
-void clearCoins() { s_coins.clear(); }
-int getCollectedCoinsCount() { int c=0; for (auto &co : s_coins) if (co.collected) ++c; return c; }
-int getTotalCoinsCount() { return (int)s_coins.size(); }
+static void addCoin(const glm::vec2 &p) {
+    s_coinGrid.Insert((uint32_t)s_coinPos.size(), p.x, p.y, p.x, p.y);
+    s_coinPos.push_back(p);
+    s_coinGroundY.push_back(getTerrainHeight(p.x, p.y));
+    s_coinPhase.push_back(++s_coinsTotal);
+}
+
+static void removeCoin(uint32_t slot) {
+    const uint32_t last = (uint32_t)s_coinPos.size() - 1;
+    s_coinGrid.Remove(slot, s_coinPos[slot].x, s_coinPos[slot].y, s_coinPos[slot].x, s_coinPos[slot].y);
+    if (slot != last) {
+        const glm::vec2 &p = s_coinPos[last];
+        s_coinGrid.Remove(last, p.x, p.y, p.x, p.y);
+        s_coinGrid.Insert(slot, p.x, p.y, p.x, p.y);
+        s_coinPos[slot] = p;
+        s_coinGroundY[slot] = s_coinGroundY[last];
+        s_coinPhase[slot] = s_coinPhase[last];
+    }
+    s_coinPos.pop_back();
+    s_coinGroundY.pop_back();
+    s_coinPhase.pop_back();
+}
+
+void setCoins(const std::vector<glm::vec2> &positions) {
+    clearCoins();
+    for (const auto &p : positions) addCoin(p);
+}
+int getCollectedCoinsCount() { return s_coinsCollected; }
+int getTotalCoinsCount() { return s_coinsTotal; }
 
 // spawn N coins randomly within a circle of radius areaRadius centered at origin
 void spawnCoins(int n, float areaRadius) {
     // Place a mix of coins on roads and beside buildings to feel like game collectibles.
-    s_coins.clear();
-    std::mt19937 rng(1234567);
+    clearCoins();
+    std::mt19937 rng(COIN_RNG_SEED);
     std::uniform_real_distribution<float> unit(0.0f, 1.0f);
 
     int placed = 0;
@@ -394,13 +522,14 @@ void spawnCoins(int n, float areaRadius) {
         float distToLake = std::sqrt((x - lakePos.x)*(x - lakePos.x) + (z - lakePos.y)*(z - lakePos.y));
         if (distToLake < lakeRad + 5.0f) continue;
         
-        s_coins.push_back(Coin{glm::vec2(x,z), false});
+        addCoin(glm::vec2(x, z));
         ++placed;
     }
 }
 
 // draw coins as small gold boxes sitting on the terrain
-void drawCoins() {
+void drawCoins(const Frustum* frustum) {
+    syncPropHeights();
     glColor3f(0.95f, 0.8f, 0.1f);
     double t = 0.0;
     // use glfwGetTime if available to animate bobbing
@@ -445,19 +574,22 @@ void drawCoins() {
         glEnd();
     };
 
-    int idx = 0;
-    for (const auto &c : s_coins) {
-        ++idx;
-        if (c.collected) continue;
-        float baseY = getTerrainHeight(c.p.x, c.p.y);
+    for (size_t i = 0; i < s_coinPos.size(); ++i) {
+        const glm::vec2 &p = s_coinPos[i];
+        const int idx = s_coinPhase[i];
+        float baseY = s_coinGroundY[i];
         // bobbing amplitude scaled to coin size
         float coinRadius = 0.42f;
+        // spinning coin plus its bob
+        const float reach = coinRadius + 0.12f;
+        glm::vec3 centre(p.x, baseY + coinRadius, p.y);
+        if (!propVisible(frustum, centre - glm::vec3(reach), centre + glm::vec3(reach))) continue;
         float bob = 0.12f * std::sin((float)t * 3.0f + idx * 0.47f);
         // position coin so it stands on the terrain (bottom touches terrain)
         float y = baseY + coinRadius + bob;
         float spin = (float)t * 60.0f + idx * 11.0f; // degrees
         glPushMatrix();
-        glTranslatef(c.p.x, y, c.p.y);
+        glTranslatef(p.x, y, p.y);
         // spin around vertical axis
         glRotatef(spin, 0.0f, 1.0f, 0.0f);
         // coin faces are in Y-Z plane (vertical), thickness along X
@@ -486,300 +618,256 @@ void drawCoins() {
 
 // check for pickups
 int collectCoinsAt(float x, float z, float pickupRadius) {
+    static thread_local std::vector<uint32_t> inReach;
+    inReach.clear();
+    s_coinGrid.Query(x - pickupRadius, z - pickupRadius, x + pickupRadius, z + pickupRadius, inReach);
     int collected = 0;
-    for (auto &c : s_coins) {
-        if (c.collected) continue;
-        float dx = x - c.p.x; float dz = z - c.p.y;
+    // Highest slot first: removing it only moves a coin from a higher slot
+    for (auto it = inReach.rbegin(); it != inReach.rend(); ++it) {
+        const glm::vec2 &c = s_coinPos[*it];
+        float dx = x - c.x; float dz = z - c.y;
         float d2 = dx*dx + dz*dz;
-        if (d2 <= pickupRadius * pickupRadius) { c.collected = true; ++collected; }
+        if (d2 <= pickupRadius * pickupRadius) { removeCoin(*it); ++collected; }
     }
+    s_coinsCollected += collected;
     return collected;
 }
 
+void addBuilding(const BuildingDef &b) {
+    s_buildingGrid.Insert((uint32_t)s_buildings.size(), b.x - b.bw * 0.5f, b.z - b.bd * 0.5f,
+                          b.x + b.bw * 0.5f, b.z + b.bd * 0.5f);
+    s_buildings.push_back(b);
+    s_buildings.back().groundY = getTerrainHeight(b.x, b.z);
+}
+
 static void ensureBuildingsInitialized() {
     if (!s_buildings.empty()) return;
-    s_buildings.push_back(BuildingDef{-4.0f, -4.0f, 2.0f, 3.0f, 2.0f, glm::vec3(0.95f,0.95f,0.6f)});
-    s_buildings.push_back(BuildingDef{6.0f, 4.0f, 1.8f, 2.5f, 1.8f, glm::vec3(0.9f,0.9f,0.5f)});
-    s_buildings.push_back(BuildingDef{8.5f, 6.5f, 1.6f, 2.0f, 1.6f, glm::vec3(0.95f,0.9f,0.55f)});
+    addBuilding(BuildingDef{-4.0f, -4.0f, 2.0f, 3.0f, 2.0f, glm::vec3(0.95f,0.95f,0.6f)});
+    addBuilding(BuildingDef{6.0f, 4.0f, 1.8f, 2.5f, 1.8f, glm::vec3(0.9f,0.9f,0.5f)});
+    addBuilding(BuildingDef{8.5f, 6.5f, 1.6f, 2.0f, 1.6f, glm::vec3(0.95f,0.9f,0.55f)});
 }
 
 // forward declare building draw helper
-static void drawBuildingAt(float wx, float wz, float bw, float bh, float bd, const glm::vec3 &windowColor);
+static void drawBuildingAt(float wx, float wy, float wz, float bw, float bh, float bd, const glm::vec3 &windowColor);
 
-void drawBuildings() {
+void drawBuildings(const Frustum* frustum) {
     ensureBuildingsInitialized();
-    for (const auto &b : s_buildings) drawBuildingAt(b.x, b.z, b.bw, b.bh, b.bd, b.windowColor);
+    syncPropHeights();
+    for (const auto &b : s_buildings) {
+        // body centred on the ground point, roof peak 0.6 above it
+        glm::vec3 lo(b.x - b.bw * 0.5f, b.groundY - b.bh * 0.5f, b.z - b.bd * 0.5f);
+        glm::vec3 hi(b.x + b.bw * 0.5f, b.groundY + b.bh * 0.5f + 0.6f, b.z + b.bd * 0.5f);
+        if (!propVisible(frustum, lo, hi)) continue;
+        drawBuildingAt(b.x, b.groundY, b.z, b.bw, b.bh, b.bd, b.windowColor);
+    }
 }
 
-void addBuilding(const BuildingDef &b) { s_buildings.push_back(b); }
-void clearBuildings() { s_buildings.clear(); }
+void clearBuildings() { s_buildings.clear(); s_buildingGrid.Clear(); }
 
 const std::vector<BuildingDef>& getBuildings() { ensureBuildingsInitialized(); return s_buildings; }
 
 bool isPositionInsideBuilding(float x, float z, float radius) {
     ensureBuildingsInitialized();
-    for (const auto &b : s_buildings) {
-        float halfW = b.bw * 0.5f;
-        float halfD = b.bd * 0.5f;
-        float dx = std::fabs(x - b.x);
-        float dz = std::fabs(z - b.z);
-        if (dx <= halfW + radius && dz <= halfD + radius) return true;
+    auto overlaps = [&](uint32_t id) {
+        const BuildingDef &b = s_buildings[id];
+        return std::fabs(x - b.x) <= b.bw * 0.5f + radius && std::fabs(z - b.z) <= b.bd * 0.5f + radius;
+    };
+    // Every footprint the circle's box can touch is listed in the cells the box covers
+    float cell = s_buildingGrid.CellSize();
+    if (std::floor((x - radius) / cell) == std::floor((x + radius) / cell) &&
+        std::floor((z - radius) / cell) == std::floor((z + radius) / cell)) {
+        const std::vector<uint32_t> *ids = s_buildingGrid.CellAt(x, z);
+        if (!ids) return false;
+        for (uint32_t id : *ids) if (overlaps(id)) return true;
+        return false;
     }
+    static thread_local std::vector<uint32_t> ids;
+    ids.clear();
+    s_buildingGrid.Query(x - radius, z - radius, x + radius, z + radius, ids);
+    for (uint32_t id : ids) if (overlaps(id)) return true;
     return false;
 }
 
-void addRoad(const Road &r) { s_roads.push_back(r); }
-void clearRoads() { s_roads.clear(); }
-
-const std::vector<Road>& getRoads() { return s_roads; }
+// Samples the road centreline on the terrain, snaps its intersection caps, picks its
+// roadside tree spots and bakes the surface into geometry
+static RoadGround snapRoad(const Road &road, RoadGeometry &geometry) {
+    RoadGround g;
+    geometry = RoadGeometry();
+    const auto &waypoints = road.pts;
+    if (waypoints.size() < 2) return g;
+    std::vector<glm::vec3> samples;
+    for (size_t i = 0; i + 1 < waypoints.size(); ++i) {
+        float x0 = waypoints[i].x, z0 = waypoints[i].y;
+        float x1 = waypoints[i+1].x, z1 = waypoints[i+1].y;
+        // finer sampling for main roads
+        float localSpacing = road.isMain ? (ROAD_SAMPLE_SPACING * 0.6f) : ROAD_SAMPLE_SPACING;
+        float dx = x1 - x0, dz = z1 - z0;
+        float segLen = std::sqrt(dx*dx + dz*dz);
+        int steps = std::max(1, (int)std::ceil(segLen / localSpacing));
+        for (int s = 0; s <= steps; ++s) {
+            float t = (float)s / (float)steps;
+            float x = x0 + dx * t;
+            float z = z0 + dz * t;
+            float y = getTerrainHeight(x, z) + 0.02f;
+            samples.push_back(glm::vec3(x,y,z));
+        }
+    }
+    if (samples.size() < 2) return g;
 
-const std::vector<glm::vec2>& getTrees() { ensureTreesInitialized(); return s_trees; }
+    // remove near-duplicate samples (can occur at segment joins)
+    std::vector<glm::vec3> uniq;
+    const float dedupEps = 1e-3f;
+    for (const auto &p : samples) {
+        if (uniq.empty() || glm::length(uniq.back() - p) > dedupEps) uniq.push_back(p);
+    }
+    if (uniq.size() < 2) return g;
+    g.hasSurface = true;
+    // Carriageway and sidewalks reach halfWidth + sidewalk past the centreline, caps a little
+    // further; caps and trees extend the bounds once snapped
+    float reach = road.halfWidth + ROAD_SIDEWALK_WIDTH + 0.04f;
+    g.lo = g.hi = uniq[0];
+    for (const auto &p : uniq) { g.lo = glm::min(g.lo, p); g.hi = glm::max(g.hi, p); }
+    g.lo -= glm::vec3(reach, 0.0f, reach);
+    g.hi += glm::vec3(reach, 0.05f, reach);
+
+    // compute total length
+    float totalLen = 0.0f;
+    for (size_t i=1;i<uniq.size();++i) totalLen += glm::length(uniq[i] - uniq[i-1]);
+    std::vector<std::vector<glm::vec3>> caps;
+    if (totalLen <= 1e-4f) {
+        bakeRoadGeometry(road, uniq, caps, ROAD_SIDEWALK_WIDTH, geometry);
+        return g;
+    }
 
-const std::vector<glm::vec3>& getStreetLights() { return s_streetLights; }
+    // intersection cap at each original waypoint so roads connect cleanly
+    for (const auto &wp : road.pts) {
+        float capR = road.halfWidth + ROAD_SIDEWALK_WIDTH + 0.02f;
+        caps.emplace_back();
+        snapFilledDisk(caps.back(), wp.x, wp.y, capR, 24);
+        caps.emplace_back();
+        snapFilledDisk(caps.back(), wp.x, wp.y, capR + 0.02f, 20);
+    }
 
-const std::vector<glm::vec2>& getCoins() {
-    std::vector<glm::vec2> coins;
-    for (const auto &c : s_coins) {
-        if (!c.collected) coins.push_back(c.p);
-    }
-    // Since it's static, but to avoid copying, perhaps make it return vector<vec2> of uncollected.
-    // But for simplicity, return all.
-    static std::vector<glm::vec2> coinPos;
-    coinPos.clear();
-    for (const auto &c : s_coins) {
-        if (!c.collected) coinPos.push_back(c.p);
-    }
-    return coinPos;
-}
-
-void drawRoads() {
-    const float sampleSpacing = 0.5f;
-    const float sidewalkWidth = 0.45f;
-    for (const auto &road : s_roads) {
-        const auto &waypoints = road.pts;
-        float roadHalfWidth = road.halfWidth;
-        if (waypoints.size() < 2) continue;
-        std::vector<glm::vec3> samples;
-        for (size_t i = 0; i + 1 < waypoints.size(); ++i) {
-            float x0 = waypoints[i].x, z0 = waypoints[i].y;
-            float x1 = waypoints[i+1].x, z1 = waypoints[i+1].y;
-            // finer sampling for main roads
-            float localSpacing = road.isMain ? (sampleSpacing * 0.6f) : sampleSpacing;
-            float dx = x1 - x0, dz = z1 - z0;
-            float segLen = std::sqrt(dx*dx + dz*dz);
-            int steps = std::max(1, (int)std::ceil(segLen / localSpacing));
-            for (int s = 0; s <= steps; ++s) {
-                float t = (float)s / (float)steps;
-                float x = x0 + dx * t;
-                float z = z0 + dz * t;
-                float y = getTerrainHeight(x, z) + 0.02f;
-                samples.push_back(glm::vec3(x,y,z));
+    // 4 trees per road at fairly spaced locations, alternating sides
+    const int treesPerRoad = 4;
+    for (int k=0;k<treesPerRoad;++k) {
+        float target = (float)(k + 1) / (treesPerRoad + 1) * totalLen; // e.g., 0.2,0.4,0.6,0.8
+        // find segment containing target
+        float acc = 0.0f;
+        for (size_t i=1;i<uniq.size();++i){
+            float seg = glm::length(uniq[i] - uniq[i-1]);
+            if (acc + seg >= target){
+                float localT = (target - acc) / seg;
+                glm::vec3 p = uniq[i-1] + (uniq[i] - uniq[i-1]) * localT;
+                glm::vec3 dir = glm::normalize(uniq[i] - uniq[i-1]);
+                glm::vec3 perp(-dir.z, 0.0f, dir.x);
+                float side = (k % 2 == 0) ? 1.0f : -1.0f;
+                float treeOffset = road.halfWidth + ROAD_SIDEWALK_WIDTH + 1.0f;
+                glm::vec3 tp = p + perp * (side * treeOffset);
+                g.treeSpots.push_back(glm::vec2(tp.x, tp.z));
+                break;
             }
+            acc += seg;
         }
-        if (samples.size() < 2) continue;
+    }
+    for (const auto &cap : caps)
+        for (const auto &v : cap) { g.lo.y = std::min(g.lo.y, v.y); g.hi.y = std::max(g.hi.y, v.y); }
+    bakeRoadGeometry(road, uniq, caps, ROAD_SIDEWALK_WIDTH, geometry);
+    return g;
+}
 
-        // remove near-duplicate samples (can occur at segment joins)
-        std::vector<glm::vec3> uniq;
-        const float dedupEps = 1e-3f;
-        for (const auto &p : samples) {
-            if (uniq.empty() || glm::length(uniq.back() - p) > dedupEps) uniq.push_back(p);
-        }
-        if (uniq.size() < 2) continue;
+// Snaps and bakes road i
+static void snapRoadAt(size_t i) {
+    RoadGeometry geometry;
+    s_roadGround[i] = snapRoad(s_roads[i], geometry);
+    s_roadMesh.SetRoad(i, geometry);
+}
 
-        // road surface (use deduped samples) - asphalt color
-        glColor3f(0.20f,0.205f,0.22f);
-        glBegin(GL_TRIANGLE_STRIP);
-        for (size_t i = 0; i < uniq.size(); ++i) {
-            glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-            glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-            glm::vec3 vec = next - prev;
-            float vecLen = glm::length(vec);
-            glm::vec3 tangent;
-            if (vecLen < 1e-5f) {
-                if (i > 0) {
-                    glm::vec3 pprev = (i >= 2) ? uniq[i-2] : prev;
-                    glm::vec3 v2 = prev - pprev;
-                    float l2 = glm::length(v2);
-                    tangent = (l2 < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : v2 / l2;
-                } else tangent = glm::vec3(1.0f,0.0f,0.0f);
-            } else tangent = vec / vecLen;
-            glm::vec3 perp(-tangent.z, 0.0f, tangent.x);
-            glm::vec3 left = uniq[i] + perp * roadHalfWidth;
-            glm::vec3 right = uniq[i] - perp * roadHalfWidth;
-            glVertex3f(left.x,left.y,left.z);
-            glVertex3f(right.x,right.y,right.z);
-        }
-        glEnd();
+void addRoad(const Road &r) {
+    s_roadIndex.AddRoad((uint32_t)s_roads.size(), r);
+    s_roads.push_back(r);
+    s_roadGround.emplace_back();
+    snapRoadAt(s_roads.size() - 1);
+}
+void clearRoads() { s_roads.clear(); s_roadGround.clear(); s_roadMesh.Clear(); s_roadIndex.Clear(); }
 
-        // sidewalks (concrete)
-        glColor3f(0.76f,0.76f,0.74f);
-        glBegin(GL_TRIANGLE_STRIP);
-        for (size_t i=0;i<uniq.size();++i){
-            glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-            glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-            glm::vec3 vec = next - prev;
-            float l = glm::length(vec);
-            glm::vec3 tangent = (l < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : vec / l;
-            glm::vec3 perp(-tangent.z,0.0f,tangent.x);
-            glm::vec3 outer = uniq[i] + perp * (roadHalfWidth + sidewalkWidth);
-            glm::vec3 inner = uniq[i] + perp * roadHalfWidth;
-            glVertex3f(outer.x, outer.y + 0.005f, outer.z);
-            glVertex3f(inner.x, inner.y + 0.005f, inner.z);
-        }
-        glEnd();
-        glBegin(GL_TRIANGLE_STRIP);
-        for (size_t i=0;i<uniq.size();++i){
-            glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-            glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-            glm::vec3 vec = next - prev;
-            float l = glm::length(vec);
-            glm::vec3 tangent = (l < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : vec / l;
-            glm::vec3 perp(-tangent.z,0.0f,tangent.x);
-            glm::vec3 inner = uniq[i] - perp * roadHalfWidth;
-            glm::vec3 outer = uniq[i] - perp * (roadHalfWidth + sidewalkWidth);
-            glVertex3f(inner.x, inner.y + 0.005f, inner.z);
-            glVertex3f(outer.x, outer.y + 0.005f, outer.z);
-        }
-        glEnd();
+// Terrain revision the snapped heights above are current with
+static unsigned s_propHeightsRevision = 0;
 
-    // center dashed line for non-main roads; solid for main roads
-        glColor3f(1.0f,1.0f,1.0f);
-        if (!road.isMain) {
-            const float dashLen = 0.8f, dashGap = 0.6f;
-            for (size_t i=1;i<uniq.size();++i){
-                glm::vec3 a = uniq[i-1]; glm::vec3 b = uniq[i];
-                glm::vec3 diff = b - a;
-                float seg = glm::length(diff);
-                if (seg < 1e-6f) continue;
-                glm::vec3 dir = diff / seg;
-                float t = 0.0f;
-                while (t < seg){
-                    float take = std::min(dashLen, seg - t);
-                    glm::vec3 p0 = a + dir * t;
-                    glm::vec3 p1 = a + dir * (t + take);
-                    glm::vec3 perp(-dir.z,0.0f,dir.x);
-                    float half = 0.06f;
-                    glBegin(GL_QUADS);
-                    glVertex3f(p0.x - perp.x*half, p0.y + 0.02f, p0.z - perp.z*half);
-                    glVertex3f(p0.x + perp.x*half, p0.y + 0.02f, p0.z + perp.z*half);
-                    glVertex3f(p1.x + perp.x*half, p1.y + 0.02f, p1.z + perp.z*half);
-                    glVertex3f(p1.x - perp.x*half, p1.y + 0.02f, p1.z - perp.z*half);
-                    glEnd();
-                    t += take + dashGap;
-                }
-            }
-        } else {
-            // solid center for main roads
-            glBegin(GL_TRIANGLE_STRIP);
-            for (size_t i=0;i<uniq.size();++i){
-                glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-                glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-                glm::vec3 vec = next - prev;
-                float l = glm::length(vec);
-                glm::vec3 dir = (l < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : vec / l;
-                glm::vec3 perp(-dir.z,0.0f,dir.x);
-                glm::vec3 cLeft = uniq[i] + perp * 0.2f;
-                glm::vec3 cRight = uniq[i] - perp * 0.2f;
-                glVertex3f(cLeft.x, cLeft.y + 0.02f, cLeft.z);
-                glVertex3f(cRight.x, cRight.y + 0.02f, cRight.z);
-            }
-            glEnd();
-        }
+static void syncPropHeights() {
+    unsigned revision = terrainRevision();
+    if (revision == s_propHeightsRevision) return;
+    auto touched = [](float minX, float minZ, float maxX, float maxZ) {
+        return terrainRegionChangedSince(s_propHeightsRevision, minX, minZ, maxX, maxZ);
+    };
+    for (auto &b : s_buildings) {
+        if (touched(b.x, b.z, b.x, b.z)) b.groundY = getTerrainHeight(b.x, b.z);
+    }
+    for (size_t i = 0; i < s_trees.size(); ++i) {
+        const glm::vec2 &t = s_trees[i];
+        if (touched(t.x, t.y, t.x, t.y)) s_treeGroundY[i] = getTerrainHeight(t.x, t.y);
+    }
+    for (size_t i = 0; i < s_streetLights.size(); ++i) {
+        const glm::vec3 &p = s_streetLights[i];
+        if (touched(p.x, p.z, p.x, p.z)) s_streetLightGroundY[i] = getTerrainHeight(p.x, p.z);
+    }
+    for (size_t i = 0; i < s_coinPos.size(); ++i) {
+        const glm::vec2 &c = s_coinPos[i];
+        if (touched(c.x, c.y, c.x, c.y)) s_coinGroundY[i] = getTerrainHeight(c.x, c.y);
+    }
+    for (size_t i = 0; i < s_roads.size(); ++i) {
+        const Road &road = s_roads[i];
+        if (road.pts.empty()) continue;
+        // caps reach past the carriageway
+        float margin = road.halfWidth + ROAD_SIDEWALK_WIDTH + 0.04f;
+        glm::vec2 lo = road.pts[0], hi = road.pts[0];
+        for (const auto &p : road.pts) { lo = glm::min(lo, p); hi = glm::max(hi, p); }
+        if (touched(lo.x - margin, lo.y - margin, hi.x + margin, hi.y + margin)) snapRoadAt(i);
+    }
+    for (size_t i = 0; i < s_ponds.size(); ++i) {
+        const glm::vec2 &c = s_ponds[i].first;
+        float reach = s_ponds[i].second + 1.2f; // outer edge of the shore band
+        if (touched(c.x - reach, c.y - reach, c.x + reach, c.y + reach)) s_pondGround[i] = snapPond(c, s_ponds[i].second);
+    }
+    s_propHeightsRevision = revision;
+}
 
-    // Draw curb/edge lines for a cleaner look
-    glLineWidth(2.0f);
-    // left curb (light concrete contrast)
-    glColor3f(0.9f,0.9f,0.9f);
-        glBegin(GL_LINE_STRIP);
-        for (size_t i=0;i<uniq.size();++i){
-            glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-            glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-            glm::vec3 vec = next - prev;
-            float l = glm::length(vec);
-            glm::vec3 tangent = (l < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : vec / l;
-            glm::vec3 perp(-tangent.z,0.0f,tangent.x);
-            glm::vec3 left = uniq[i] + perp * (roadHalfWidth + 0.01f);
-            glVertex3f(left.x, left.y + 0.03f, left.z);
-        }
-        glEnd();
-        // right curb
-        glBegin(GL_LINE_STRIP);
-        for (size_t i=0;i<uniq.size();++i){
-            glm::vec3 prev = (i==0) ? uniq[i] : uniq[i-1];
-            glm::vec3 next = (i+1==uniq.size()) ? uniq[i] : uniq[i+1];
-            glm::vec3 vec = next - prev;
-            float l = glm::length(vec);
-            glm::vec3 tangent = (l < 1e-5f) ? glm::vec3(1.0f,0.0f,0.0f) : vec / l;
-            glm::vec3 perp(-tangent.z,0.0f,tangent.x);
-            glm::vec3 right = uniq[i] - perp * (roadHalfWidth + 0.01f);
-            glVertex3f(right.x, right.y + 0.03f, right.z);
-        }
-        glEnd();
-        glLineWidth(1.0f);
-
-        // Plant 4 trees per road at fairly spaced locations, alternating sides
-        const int treesPerRoad = 4;
-        // compute total length
-        float totalLen = 0.0f;
-        for (size_t i=1;i<uniq.size();++i) totalLen += glm::length(uniq[i] - uniq[i-1]);
-        if (totalLen > 1e-4f) {
-            std::vector<float> ts;
-            for (int k=1;k<=treesPerRoad;++k) ts.push_back((float)k/(treesPerRoad+1)); // e.g., 0.2,0.4,0.6,0.8
-            // Before placing trees, draw an intersection cap at each original waypoint so roads connect cleanly
-            for (const auto &wp : road.pts) {
-                float capR = road.halfWidth + sidewalkWidth + 0.02f;
-                // intersection cap matches asphalt
-                glColor3f(0.20f, 0.205f, 0.22f);
-                drawFilledDisk(wp.x, wp.y, capR, 24);
-                // slightly lighter concrete skirt
-                glColor3f(0.76f, 0.76f, 0.74f);
-                drawFilledDisk(wp.x, wp.y, capR + 0.02f, 20);
-            }
+const std::vector<Road>& getRoads() { return s_roads; }
 
-            for (int k=0;k<treesPerRoad;++k) {
-                float target = ts[k] * totalLen;
-                // find segment containing target
-                float acc = 0.0f; bool placed=false;
-                for (size_t i=1;i<uniq.size() && !placed;++i){
-                    float seg = glm::length(uniq[i] - uniq[i-1]);
-                    if (acc + seg >= target){
-                        float localT = (target - acc) / seg;
-                        glm::vec3 p = uniq[i-1] + (uniq[i] - uniq[i-1]) * localT;
-                        glm::vec3 dir = glm::normalize(uniq[i] - uniq[i-1]);
-                        glm::vec3 perp(-dir.z, 0.0f, dir.x);
-                        // alternate sides
-                        float side = (k % 2 == 0) ? 1.0f : -1.0f;
-                        float treeOffset = roadHalfWidth + sidewalkWidth + 1.0f;
-                        glm::vec3 tp = p + perp * (side * treeOffset);
-                        // ensure tree is not on ANY road (check all s_roads segments)
-                        glm::vec2 t2(tp.x, tp.z);
-                        bool tooClose = false;
-                        for (const auto &other : s_roads) {
-                            for (size_t si = 1; si < other.pts.size(); ++si) {
-                                float d = pointSegDist2D(t2, other.pts[si-1], other.pts[si]);
-                                // strict check: tree center must be outside the road surface.
-                                // consider the road half-width plus a small safety margin (no sidewalk included)
-                                const float safetyMargin = 0.05f;
-                                if (d <= (other.halfWidth + safetyMargin)) { tooClose = true; break; }
-                            }
-                            if (tooClose) break;
-                        }
-                        if (!tooClose) {
-                            // draw a tree at tp.x,tp.z (use drawTree helper)
-                            drawTree(tp.x, tp.z);
-                        }
-                        placed = true;
-                    }
-                    acc += seg;
-                }
-            }
+const RoadIndex& getRoadIndex() { return s_roadIndex; }
+
+const std::vector<glm::vec2>& getTrees() { ensureTreesInitialized(); return s_trees; }
+
+const std::vector<glm::vec3>& getStreetLights() { return s_streetLights; }
+
+const std::vector<glm::vec2>& getCoins() { return s_coinPos; }
+
+void drawRoads(const Frustum* frustum) {
+    syncPropHeights();
+    s_visibleRoads.clear();
+    for (size_t ri = 0; ri < s_roads.size(); ++ri) {
+        const RoadGround &ground = s_roadGround[ri];
+        if (ground.hasSurface && propVisible(frustum, ground.lo, ground.hi)) s_visibleRoads.push_back((uint32_t)ri);
+    }
+    // asphalt, sidewalks, markings, caps and curbs of every visible road
+    s_roadMesh.Draw(s_visibleRoads);
+}
+
+void plantRoadsideTrees() {
+    // planted next to the default trees, which only appear while the registry is empty
+    ensureTreesInitialized();
+    // strict check: a tree centre must be outside every road surface, with a small safety
+    // margin (sidewalks not included)
+    const float safetyMargin = 0.05f;
+    for (const auto &ground : s_roadGround) {
+        for (const auto &spot : ground.treeSpots) {
+            if (!s_roadIndex.NearSurface(spot, safetyMargin)) addTree(spot);
         }
     }
 }
 
 // Building drawing helper (windows + frame + roof)
-static void drawBuildingAt(float wx, float wz, float bw, float bh, float bd, const glm::vec3 &windowColor){
-    float wy = getTerrainHeight(wx, wz);
+static void drawBuildingAt(float wx, float wy, float wz, float bw, float bh, float bd, const glm::vec3 &windowColor){
     glPushMatrix();
     glTranslatef(wx, wy, wz);
 
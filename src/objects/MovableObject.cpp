@@ -16,19 +16,6 @@ void MovableObject::MoveForward(float amount) {
     glm::vec3 proposed = position + forward * amount;
     // Keep movement confined to XZ; radius of player for collision
     const float radius = 0.6f; // slightly larger to prevent entering thin building edges
-    // Terrain bounds (match drawTerrain grid: SIZE=120, SPACING=0.75)
-    const int TERRAIN_SIZE = 120;
-    const float SPACING = 0.75f;
-    const float minX = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float minZ = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float maxX = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    const float maxZ = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    
-    // Check bounds first
-    if (proposed.x < minX || proposed.x > maxX || proposed.z < minZ || proposed.z > maxZ) {
-        return; // Don't move if out of bounds
-    }
-    
     // Check building collision; if not colliding, accept move
     if (!isPositionInsideBuilding(proposed.x, proposed.z, radius)) {
         position = proposed;
@@ -39,18 +26,6 @@ void MovableObject::MoveForward(float amount) {
 void MovableObject::MoveRight(float amount) {
     glm::vec3 proposed = position + right * amount;
     const float radius = 0.6f;
-    const int TERRAIN_SIZE = 120;
-    const float SPACING = 0.75f;
-    const float minX = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float minZ = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float maxX = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    const float maxZ = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    
-    // Check bounds first
-    if (proposed.x < minX || proposed.x > maxX || proposed.z < minZ || proposed.z > maxZ) {
-        return; // Don't move if out of bounds
-    }
-    
     // Check building collision; if not colliding, accept move
     if (!isPositionInsideBuilding(proposed.x, proposed.z, radius)) {
         position = proposed;
@@ -64,18 +39,6 @@ void MovableObject::MoveInDirection(const glm::vec3& direction, float amount) {
     glm::vec3 moveDir = glm::vec3(normalizedDir.x, 0.0f, normalizedDir.z);
     glm::vec3 proposed = position + moveDir * amount;
     const float radius = 0.6f;
-    const int TERRAIN_SIZE = 120;
-    const float SPACING = 0.75f;
-    const float minX = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float minZ = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float maxX = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    const float maxZ = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    
-    // Check bounds first
-    if (proposed.x < minX || proposed.x > maxX || proposed.z < minZ || proposed.z > maxZ) {
-        return; // Don't move if out of bounds
-    }
-    
     // Check building collision; if not colliding, accept move
     if (!isPositionInsideBuilding(proposed.x, proposed.z, radius)) {
         position = proposed;
@@ -220,18 +183,9 @@ void MovableObject::Update(float dt) {
     // Attempt to move by velocity*dt, with collision check
     glm::vec3 proposed = position + velocity * dt;
     const float radius = 0.6f;
-    const int TERRAIN_SIZE = 120;
-    const float SPACING = 0.75f;
-    const float minX = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float minZ = -((TERRAIN_SIZE/2) * SPACING) + radius;
-    const float maxX = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    const float maxZ = ((TERRAIN_SIZE/2) - 1) * SPACING - radius;
-    
-    // Check bounds first - if out of bounds, stop movement
-    if (proposed.x < minX || proposed.x > maxX || proposed.z < minZ || proposed.z > maxZ) {
-        velocity = glm::vec3(0.0f);
-    } else if (!isPositionInsideBuilding(proposed.x, proposed.z, radius)) {
-        // Within bounds and no collision - accept move
+    // Terrain streams around the player, so there are no world bounds to check
+    if (!isPositionInsideBuilding(proposed.x, proposed.z, radius)) {
+        // No collision - accept move
         position = proposed;
         stayOnTerrain();
     } else {
@@ -1,6 +1,7 @@
 #include "../../include/scenes/PlayScene.h"
 #include <GL/glu.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <cmath>
 
@@ -8,7 +9,16 @@
 #include <string>
 #include "skybox/skybox.h"
 #include "../../include/city/City.h"
+#include "../../include/city/WorldCache.h"
+#include "../../include/core/Hash.h"
+#include "../../include/camera/Frustum.h"
 #include "../../include/objects.h"
+#include <chrono>
+
+// Bump whenever the code of generateCity or spawnCoins changes what they generate, so old
+// world caches stop matching. Their arguments, seeds and the terrain are hashed in OnAttach.
+static const uint32_t WORLD_GENERATOR_VERSION = 1;
+static const char* WORLD_CACHE_DIR = "cache";
 
 PlayScene::PlayScene()
     : m_Player(0.0f,0.0f,0.0f), m_Camera(&m_Player) {
@@ -26,8 +36,6 @@ PlayScene::PlayScene()
     faces.push_back(skyboxDir + "back.png");
     
     loadSkybox(faces);
-
-    generateCity(50, 40.0f, glm::vec2(0,0));
 }
 
 void PlayScene::OnAttach(GLFWwindow* window) {
@@ -47,38 +55,61 @@ void PlayScene::OnAttach(GLFWwindow* window) {
     terrainClearMountains();
 
     // --- Border mountains recalculated to match the current terrain extents ---
-    const int TERRAIN_SIZE = 150; // must match terrain.cpp
-    const float SPACING = 0.6f;
-    const float halfWorld = (TERRAIN_SIZE / 2) * SPACING; // e.g. 100 * 0.5 = 50.0
+    const float halfWorld = terrainHalfExtent(); // 45 with the default layout
     const float minEdge = -halfWorld;
-    const float maxEdge = (TERRAIN_SIZE/2 - 1) * SPACING;
+    const float maxEdge = halfWorld - 0.6f;
+    struct BorderMountain { glm::vec2 center; float radius; float height; };
     // place mountains just inside the perimeter with some spread
-    // left column (x ~ minEdge + 3)
-    terrainAddMountain(glm::vec2(minEdge + 3.0f, -halfWorld * 0.6f), 12.0f, 4.2f);
-    terrainAddMountain(glm::vec2(minEdge + 3.0f, 0.0f), 14.0f, 5.0f);
-    terrainAddMountain(glm::vec2(minEdge + 3.0f, halfWorld * 0.6f), 12.0f, 4.0f);
-    // top row (z ~ minEdge + 3)
-    terrainAddMountain(glm::vec2(-halfWorld * 0.6f, minEdge + 3.0f), 10.0f, 3.6f);
-    terrainAddMountain(glm::vec2(0.0f, minEdge + 3.0f), 16.0f, 5.2f);
-    terrainAddMountain(glm::vec2(halfWorld * 0.6f, minEdge + 3.0f), 10.0f, 3.6f);
-    // right column (x ~ maxEdge - 3)
-    terrainAddMountain(glm::vec2(maxEdge - 3.0f, -halfWorld * 0.6f), 12.0f, 4.0f);
-    terrainAddMountain(glm::vec2(maxEdge - 3.0f, 0.0f), 14.0f, 4.8f);
-    terrainAddMountain(glm::vec2(maxEdge - 3.0f, halfWorld * 0.6f), 12.0f, 4.0f);
-    // bottom row (z ~ maxEdge - 3)
-    terrainAddMountain(glm::vec2(halfWorld * 0.6f, maxEdge - 3.0f), 10.0f, 3.4f);
-    terrainAddMountain(glm::vec2(0.0f, maxEdge - 3.0f), 16.0f, 5.0f);
-    terrainAddMountain(glm::vec2(-halfWorld * 0.6f, maxEdge - 3.0f), 10.0f, 3.4f);
-
-    // Generate a simple city with ~30 houses around the origin
+    const BorderMountain mountains[] = {
+        // left column (x ~ minEdge + 3)
+        { glm::vec2(minEdge + 3.0f, -halfWorld * 0.6f), 12.0f, 4.2f },
+        { glm::vec2(minEdge + 3.0f, 0.0f), 14.0f, 5.0f },
+        { glm::vec2(minEdge + 3.0f, halfWorld * 0.6f), 12.0f, 4.0f },
+        // top row (z ~ minEdge + 3)
+        { glm::vec2(-halfWorld * 0.6f, minEdge + 3.0f), 10.0f, 3.6f },
+        { glm::vec2(0.0f, minEdge + 3.0f), 16.0f, 5.2f },
+        { glm::vec2(halfWorld * 0.6f, minEdge + 3.0f), 10.0f, 3.6f },
+        // right column (x ~ maxEdge - 3)
+        { glm::vec2(maxEdge - 3.0f, -halfWorld * 0.6f), 12.0f, 4.0f },
+        { glm::vec2(maxEdge - 3.0f, 0.0f), 14.0f, 4.8f },
+        { glm::vec2(maxEdge - 3.0f, halfWorld * 0.6f), 12.0f, 4.0f },
+        // bottom row (z ~ maxEdge - 3)
+        { glm::vec2(halfWorld * 0.6f, maxEdge - 3.0f), 10.0f, 3.4f },
+        { glm::vec2(0.0f, maxEdge - 3.0f), 16.0f, 5.0f },
+        { glm::vec2(-halfWorld * 0.6f, maxEdge - 3.0f), 10.0f, 3.4f },
+    };
+    for (const auto &m : mountains) terrainAddMountain(m.center, m.radius, m.height);
+
     // Place the lake between two chosen border mountains for a scenic look
     glm::vec2 mountainA(minEdge + 3.0f, 0.0f); // left-column middle mountain
     glm::vec2 mountainB(-halfWorld * 0.6f, minEdge + 3.0f); // top-row left mountain
     glm::vec2 lakeCenter = (mountainA + mountainB) * 0.5f;
-    generateCity(30, 40.0f, lakeCenter);
-    // spawn collectible coins around the city
-    spawnCoins(60, 40.0f);
 
+    const int cityHouses = 50, lakeHouses = 30, coinCount = 60;
+    const float cityRadius = 40.0f;
+    const glm::vec2 cityCenter(0.0f, 0.0f);
+
+    // The city, coins and terrain grid only depend on these inputs, so a warm start
+    // restores them from the world cache instead of generating them again
+    Hasher key;
+    key.Add(WORLD_GENERATOR_VERSION);
+    key.Add(terrainContentKey()); // layout, base surface, erosion, the mountains above
+    key.Add(CITY_RNG_SEED);
+    key.Add(COIN_RNG_SEED);
+    key.Add(cityHouses); key.Add(lakeHouses); key.Add(coinCount);
+    key.Add(cityRadius); key.Add(cityCenter); key.Add(lakeCenter);
+    if (!loadWorldCache(WORLD_CACHE_DIR, key.Value())) {
+        auto start = std::chrono::steady_clock::now();
+        generateCity(cityHouses, cityRadius, cityCenter);
+        // Generate a simple city with ~30 houses around the lake
+        generateCity(lakeHouses, cityRadius, lakeCenter);
+        // spawn collectible coins around the city
+        spawnCoins(coinCount, cityRadius);
+        terrainUpdateHeightCache();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "World generated in " << ms << " ms\n";
+        saveWorldCache(WORLD_CACHE_DIR, key.Value(), ms);
+    }
 }
 
 void PlayScene::OnFramebufferResize(int width, int height) {
@@ -87,7 +118,9 @@ void PlayScene::OnFramebufferResize(int width, int height) {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     float aspect = (float)width/(float)height;
-    glFrustum(-0.1f*aspect,0.1f*aspect,-0.1f,0.1f,0.2f,100.0f);
+    // Kept on the CPU too, for extracting the view frustum
+    m_Projection = glm::frustum(-0.1f*aspect,0.1f*aspect,-0.1f,0.1f,0.2f,100.0f);
+    glLoadMatrixf(glm::value_ptr(m_Projection));
     glMatrixMode(GL_MODELVIEW);
 }
 
@@ -127,6 +160,8 @@ void PlayScene::OnScroll(double xoff, double yoff) {
 }
 
 void PlayScene::OnUpdate(float dt) {
+    // Frame boundary: last frame's terrain edits become visible to every reader at once
+    terrainPublish();
     m_Camera.Update();
     // Build desired movement from input flags for smooth walking
     glm::vec3 forward = m_Camera.GetForward(); forward.y = 0; if (glm::length(forward) > 0.0001f) forward = glm::normalize(forward);
@@ -187,16 +222,21 @@ void PlayScene::OnRender() {
     // This is your original code to set up the main camera for the scene
     glm::vec3 eye = m_Camera.GetPosition();
     glm::vec3 up(0,1,0);
-    gluLookAt(eye.x, eye.y, eye.z, center.x, center.y, center.z, up.x, up.y, up.z);
-
-    drawTerrain();
+    glm::mat4 view = glm::lookAt(eye, center, up);
+    glMultMatrixf(glm::value_ptr(view));
+    // Everything outside the view is skipped; the counts are in terrainResidencyStats and
+    // getPropCullStats
+    Frustum frustum(m_Projection * view);
+    resetPropCullStats();
+
+    drawTerrain(eye, m_Player.GetPosition(), &frustum);
     // draw water bodies first (recessed), then roads, buildings, trees and street lights
-    drawPonds();
-    drawRoads();
-    drawBuildings();
-    drawTrees();
-    drawStreetLights();
-    drawCoins();
+    drawPonds(&frustum);
+    drawRoads(&frustum);
+    drawBuildings(&frustum);
+    drawTrees(&frustum);
+    drawStreetLights(&frustum);
+    drawCoins(&frustum);
     m_Player.Draw();
 
     // Draw HUD: numeric coin counter (top-left) using a simple 7-segment style
@@ -1,148 +1,756 @@
 #include <GL/glew.h>
 #include <cmath>
+#include <cstdio>
 #include <vector>
+#include <string>
 #include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <sys/stat.h>
 #include <glm/glm.hpp>
 // Allow terrain to consult pond definitions so we can carve basins
 #include "../include/objects.h"
 #include "terrain.h"
+#include "terrain/TerrainQuadtree.h"
+#include "terrain/TerrainFeatures.h"
+#include "terrain/TerrainHeightPyramid.h"
+#include "terrain/TerrainSharedGrid.h"
+#include "terrain/TerrainCompressedHeights.h"
+#include "terrain/TerrainLayers.h"
+#include "core/ThreadPool.h"
+#include "core/Hash.h"
+#include "core/Rcu.h"
 
-// Internal mountain data
-struct Mountain {
-    glm::vec2 center; // (x, z)
-    float radius;
-    float height;
+// Cached height grid: one sample per finest terrain vertex, so mesh vertices read exact
+// values and everything in between is bilinearly interpolated. Large grids are held in
+// packed instead of heights (see TerrainHeightStorage). Rows, pyramid levels and tiles are
+// shared between copies of a grid and copied on write, so publishing a copy costs a
+// pointer per band or tile and an edit copies only what it changes.
+struct HeightGrid {
+    TerrainSharedGrid heights; // dim x dim, row-major in z
+    TerrainCompressedHeights packed;
+    TerrainHeightPyramid pyramid; // min/max pyramid over heights, for raycasts
+    bool compressed = false;
+    int dim = 0;
+    float origin = 0.0f;
+    float spacing = 1.0f;
+    bool valid = false;
 };
 
-static std::vector<Mountain> s_mountains;
+// What height queries read: the features and the grid evaluated from them, as of one edit
+struct TerrainSnapshot {
+    TerrainFeatureArrays features;
+    HeightGrid grid;
+    unsigned revision = 0;
+};
+
+// The main thread's copy, which edits change in place; ponds are mirrored from getPonds()
+// and the grid refreshed from the features lazily. Main-thread queries read it directly.
+// Every other thread reads the copy terrainPublish last swapped in (read-copy-update), so
+// those reads never lock, never rebuild anything and never see half an edit.
+static TerrainSnapshot s_edit;
+static RcuPointer<TerrainSnapshot> s_published;
+static const TerrainSnapshot s_noSnapshot; // read before the first publish
+static bool s_featuresDirty = true; // ponds need mirroring again
+static bool s_publishPending = true;
+// Regions edited since the grid was last refreshed, updated without touching the rest of it
+static std::vector<glm::vec4> s_dirtyRegions; // (minX, minZ, maxX, maxZ)
+static std::vector<float> s_gridCopy; // terrainHeightCache's contiguous copy
+// Static initialization runs on the main thread
+static const std::thread::id s_editThread = std::this_thread::get_id();
+// Snapshot pinned by the innermost TerrainReadScope of this thread
+static thread_local const TerrainSnapshot* t_pinned = nullptr;
+static std::string s_heightmapPath;
+
+// Erosion settings; the offsets over the central tile are recomputed (or reloaded) whenever
+// the layout or base surface changes while erosion is enabled
+static TerrainErosion s_erosion;
+static std::string s_erosionCacheDir; // copied, the caller's string need not outlive the call
+static bool s_erosionEnabled = false;
+static void refreshErosion();
+
+static TerrainLayout s_layout;
+static TerrainStreaming s_streaming;
+
+static TerrainHeightStorage s_heightStorage;
+static TerrainQuadtree s_terrainQuadtree;
+
+// Bumped on every edit so retained data built from the terrain can detect staleness
+static unsigned s_terrainRevision = 1;
+
+// Recent edits, oldest first, so retained data can tell whether an edit touched it.
+// Entries older than the cap are dropped; anything built before the newest dropped edit
+// is treated as changed everywhere.
+struct TerrainEdit {
+    unsigned revision;
+    float minX, minZ, maxX, maxZ;
+};
+static std::vector<TerrainEdit> s_editHistory;
+static unsigned s_droppedEditRevision = 0;
+static const size_t EDIT_HISTORY_CAP = 256;
+
+static void recordEdit(float minX, float minZ, float maxX, float maxZ) {
+    ++s_terrainRevision;
+    if (s_editHistory.size() >= EDIT_HISTORY_CAP) {
+        size_t drop = s_editHistory.size() / 2;
+        s_droppedEditRevision = s_editHistory[drop - 1].revision;
+        s_editHistory.erase(s_editHistory.begin(), s_editHistory.begin() + drop);
+    }
+    s_editHistory.push_back(TerrainEdit{ s_terrainRevision, minX, minZ, maxX, maxZ });
+    s_featuresDirty = true;
+    s_publishPending = true;
+}
+
+void terrainInvalidateHeightCache() {
+    const float inf = std::numeric_limits<float>::infinity();
+    recordEdit(-inf, -inf, inf, inf);
+    s_edit.grid.valid = false;
+    s_dirtyRegions.clear();
+}
+
+void terrainInvalidateRegion(float minX, float minZ, float maxX, float maxZ) {
+    recordEdit(minX, minZ, maxX, maxZ);
+    if (s_edit.grid.valid) s_dirtyRegions.push_back(glm::vec4(minX, minZ, maxX, maxZ));
+}
+
+void terrainReloadPonds() {
+    const float inf = std::numeric_limits<float>::infinity();
+    recordEdit(-inf, -inf, inf, inf);
+}
+
+bool terrainRegionChangedSince(unsigned revision, float minX, float minZ, float maxX, float maxZ) {
+    if (revision < s_droppedEditRevision) return true;
+    for (auto it = s_editHistory.rbegin(); it != s_editHistory.rend() && it->revision > revision; ++it) {
+        if (it->minX <= maxX && it->maxX >= minX && it->minZ <= maxZ && it->maxZ >= minZ) return true;
+    }
+    return false;
+}
+
+unsigned terrainRevision() {
+    return s_terrainRevision;
+}
+
+void terrainSetLayout(const TerrainLayout& layout) {
+    s_layout = layout;
+    // Published snapshots keep their own references to the old grid
+    s_edit.grid.heights.Clear();
+    s_edit.grid.packed.Clear();
+    s_edit.grid.pyramid.Clear();
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+const TerrainLayout& terrainGetLayout() {
+    return s_layout;
+}
+
+int terrainWorldQuads() {
+    return s_layout.chunkQuads << s_layout.levels;
+}
+
+float terrainHalfExtent() {
+    return (terrainWorldQuads() / 2) * s_layout.spacing;
+}
+
+// A dome changes the terrain inside its radius, and the whole basin of any pond whose
+// centre it covers (basins are carved relative to the base height at the centre)
+static void invalidateMountainRegion(float x, float z, float radius) {
+    terrainInvalidateRegion(x - radius, z - radius, x + radius, z + radius);
+    for (const auto& pp : getPonds()) {
+        float dx = pp.first.x - x, dz = pp.first.y - z;
+        if (dx*dx + dz*dz < radius*radius) {
+            float r = pp.second;
+            terrainInvalidateRegion(pp.first.x - r, pp.first.y - r, pp.first.x + r, pp.first.y + r);
+        }
+    }
+}
 
 void terrainAddMountain(const glm::vec2& center, float radius, float height) {
-    s_mountains.push_back(Mountain{center, radius, height});
+    TerrainFeatureArrays& f = s_edit.features;
+    f.mountainIndex.Insert((uint32_t)f.MountainCount(),
+                           center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    f.mountainX.push_back(center.x);
+    f.mountainZ.push_back(center.y);
+    f.mountainRadius.push_back(radius);
+    f.mountainHeight.push_back(height);
+    invalidateMountainRegion(center.x, center.y, radius);
 }
 
 void terrainClearMountains() {
-    s_mountains.clear();
+    TerrainFeatureArrays& f = s_edit.features;
+    for (size_t k = 0; k < f.MountainCount(); ++k)
+        invalidateMountainRegion(f.mountainX[k], f.mountainZ[k], f.mountainRadius[k]);
+    f.mountainIndex.Clear();
+    f.mountainX.clear();
+    f.mountainZ.clear();
+    f.mountainRadius.clear();
+    f.mountainHeight.clear();
+}
+
+// Sources are replaced rather than changed in place: snapshots still being read keep the
+// old one alive
+bool terrainSetHeightmap(const char* path) {
+    auto heightmap = std::make_shared<TerrainHeightmap>();
+    bool ok = heightmap->Open(path);
+    s_edit.features.heightmapOwner = ok ? heightmap : nullptr;
+    s_edit.features.heightmap = s_edit.features.heightmapOwner.get();
+    s_heightmapPath = ok ? path : "";
+    refreshErosion();
+    terrainInvalidateHeightCache();
+    return ok;
+}
+
+void terrainClearHeightmap() {
+    s_edit.features.heightmapOwner.reset();
+    s_edit.features.heightmap = nullptr;
+    s_heightmapPath.clear();
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+void terrainSetNoise(const TerrainNoise& noise) {
+    s_edit.features.noiseOwner = std::make_shared<const TerrainNoise>(noise);
+    s_edit.features.noise = s_edit.features.noiseOwner.get();
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+void terrainClearNoise() {
+    s_edit.features.noiseOwner.reset();
+    s_edit.features.noise = nullptr;
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+// Cache key of the erosion result: everything the eroded grid is derived from. Fields are
+// hashed one by one since the structs have padding.
+static uint64_t erosionKey() {
+    Hasher h;
+    h.Add(s_layout.chunkQuads);
+    h.Add(s_layout.levels);
+    h.Add(s_layout.spacing);
+    const TerrainFeatureArrays& f = s_edit.features;
+    if (f.heightmap) {
+        h.Add('M');
+        h.AddString(s_heightmapPath.c_str());
+        h.Add(f.heightmap->Header());
+    } else if (f.noise) {
+        const TerrainNoise& n = *f.noise;
+        h.Add('N');
+        h.Add(n.simplex); h.Add(n.seed); h.Add(n.octaves); h.Add(n.frequency); h.Add(n.lacunarity);
+        h.Add(n.gain); h.Add(n.amplitude); h.Add(n.ridged); h.Add(n.warpStrength); h.Add(n.warpFrequency);
+    } else {
+        h.Add('H');
+    }
+    const TerrainErosion& e = s_erosion;
+    h.Add(e.seed); h.Add(e.droplets); h.Add(e.dropletLifetime); h.Add(e.inertia);
+    h.Add(e.sedimentCapacity); h.Add(e.minSedimentCapacity); h.Add(e.erodeSpeed); h.Add(e.depositSpeed);
+    h.Add(e.evaporateSpeed); h.Add(e.gravity); h.Add(e.thermalIterations); h.Add(e.talusSlope);
+    h.Add(e.thermalRate); h.Add(e.tileSize);
+    return h.Value();
+}
+
+uint64_t terrainContentKey() {
+    Hasher h;
+    h.Add(erosionKey());
+    h.Add(s_erosionEnabled);
+    const TerrainFeatureArrays& f = s_edit.features;
+    h.Add((uint64_t)f.MountainCount());
+    for (size_t k = 0; k < f.MountainCount(); ++k) {
+        h.Add(f.mountainX[k]); h.Add(f.mountainZ[k]); h.Add(f.mountainRadius[k]); h.Add(f.mountainHeight[k]);
+    }
+    const TerrainHeightStorage& st = s_heightStorage;
+    h.Add(st.compressFromDim); h.Add(st.tileSize); h.Add(st.maxError);
+    return h.Value();
+}
+
+static void refreshErosion() {
+    s_edit.features.erosionOwner.reset();
+    s_edit.features.erosion = nullptr;
+    if (!s_erosionEnabled) return;
+
+    auto start = std::chrono::steady_clock::now();
+    int dim = terrainWorldQuads() + 1;
+    float spacing = s_layout.spacing;
+    float origin = -(terrainWorldQuads() / 2) * spacing;
+    uint64_t key = erosionKey();
+    std::string path;
+    if (!s_erosionCacheDir.empty()) {
+        mkdir(s_erosionCacheDir.c_str(), 0755); // fails harmlessly if it exists
+        char name[64];
+        std::snprintf(name, sizeof(name), "/erosion-%016llx.bin", (unsigned long long)key);
+        path = s_erosionCacheDir + name;
+    }
+    auto map = std::make_shared<TerrainErosionMap>();
+    bool cached = !path.empty() && map->Load(path, key, dim, origin, spacing);
+    if (!cached) {
+        std::vector<float> base((size_t)dim * dim);
+        ThreadPool::Shared().ParallelFor(0, dim, [&](int j) {
+            for (int i = 0; i < dim; ++i)
+                base[(size_t)j * dim + i] = terrainLayerHeight(s_edit.features, origin + i * spacing, origin + j * spacing,
+                                                                      TerrainLayers::Surface);
+        });
+        map->Compute(s_erosion, base, dim, origin, spacing, ThreadPool::Shared());
+        if (!path.empty()) map->Save(path, key);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Terrain erosion %s (%dx%d samples) in %.1f ms\n", cached ? "loaded from cache" : "computed", dim, dim, ms);
+    s_edit.features.erosionOwner = map;
+    s_edit.features.erosion = map.get();
+}
+
+void terrainSetErosion(const TerrainErosion& erosion) {
+    s_erosion = erosion;
+    s_erosion.cacheDir = nullptr;
+    s_erosionCacheDir = erosion.cacheDir ? erosion.cacheDir : "";
+    s_erosionEnabled = true;
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+void terrainClearErosion() {
+    s_erosionEnabled = false;
+    refreshErosion();
+    terrainInvalidateHeightCache();
+}
+
+static bool onEditThread() {
+    return std::this_thread::get_id() == s_editThread;
+}
+
+// Mirrors getPonds() into the edit copy. Basin depth and the base height at each pond
+// centre are per-pond constants.
+static void syncEditFeatures() {
+    if (!s_featuresDirty) return;
+    TerrainFeatureArrays& f = s_edit.features;
+    f.pondIndex.Clear();
+    f.pondX.clear();
+    f.pondZ.clear();
+    f.pondRadius.clear();
+    f.pondCenterBase.clear();
+    f.pondMaxDepth.clear();
+    for (const auto& pp : getPonds()) {
+        float r = pp.second;
+        f.pondIndex.Insert((uint32_t)f.pondX.size(),
+                           pp.first.x - r, pp.first.y - r, pp.first.x + r, pp.first.y + r);
+        f.pondX.push_back(pp.first.x);
+        f.pondZ.push_back(pp.first.y);
+        f.pondRadius.push_back(pp.second);
+        f.pondCenterBase.push_back(terrainLayerHeight(f, pp.first.x, pp.first.y, TerrainLayers::Base));
+        f.pondMaxDepth.push_back(std::min(3.0f, pp.second * 0.35f));
+    }
+    s_featuresDirty = false;
+}
+
+// Evaluates and compresses every sample of one tile of a compressed grid
+static void encodeHeightTile(HeightGrid& g, const TerrainFeatureArrays& f, int tx, int tz) {
+    int i0, j0, n;
+    g.packed.TileSamples(tx, tz, i0, j0, n);
+    std::vector<float> xs(n), zs(n), samples((size_t)n * n);
+    for (int i = 0; i < n; ++i) xs[i] = g.origin + (i0 + i) * g.spacing;
+    for (int j = 0; j < n; ++j) {
+        std::fill(zs.begin(), zs.end(), g.origin + (j0 + j) * g.spacing);
+        terrainLayerHeightBatch(f, xs.data(), zs.data(), &samples[(size_t)j * n], n);
+    }
+    g.packed.EncodeTile(tx, tz, samples.data());
+}
+
+// Evaluates samples [i0, i0 + n) of rows j0..j1 into the grid, spread over the pool. Rows
+// are unshared here first: only the calling (editing) thread may copy bands.
+static void evaluateHeightRows(HeightGrid& g, const TerrainFeatureArrays& f, int i0, int n, int j0, int j1) {
+    std::vector<float*> rows((size_t)(j1 - j0 + 1));
+    for (int j = j0; j <= j1; ++j) rows[j - j0] = g.heights.MutableRow(j) + i0;
+    ThreadPool::Shared().ParallelFor(j0, j1 + 1, [&g, &f, &rows, i0, n, j0](int j) {
+        std::vector<float> xs(n), zs(n, g.origin + j * g.spacing);
+        for (int i = 0; i < n; ++i) xs[i] = g.origin + (i0 + i) * g.spacing;
+        terrainLayerHeightBatch(f, xs.data(), zs.data(), rows[j - j0], n);
+    });
+}
+
+// Recomputes the samples inside one edited rectangle (grown by a sample so the bilinear
+// cells along its border are refreshed too)
+static void updateHeightGridRegion(HeightGrid& g, const TerrainFeatureArrays& f, const glm::vec4& r) {
+    int i0 = std::max((int)std::floor((r.x - g.origin) / g.spacing) - 1, 0);
+    int j0 = std::max((int)std::floor((r.y - g.origin) / g.spacing) - 1, 0);
+    int i1 = std::min((int)std::ceil((r.z - g.origin) / g.spacing) + 1, g.dim - 1);
+    int j1 = std::min((int)std::ceil((r.w - g.origin) / g.spacing) + 1, g.dim - 1);
+    if (i0 > i1 || j0 > j1) return;
+    if (g.compressed) {
+        // Whole tiles are re-encoded, since an edit can change a tile's range
+        int tx0, tz0, tx1, tz1;
+        g.packed.TilesCovering(i0, j0, i1, j1, tx0, tz0, tx1, tz1);
+        int w = tx1 - tx0 + 1;
+        ThreadPool::Shared().ParallelFor(0, w * (tz1 - tz0 + 1), [&g, &f, tx0, tz0, w](int t) {
+            encodeHeightTile(g, f, tx0 + t % w, tz0 + t / w);
+        });
+        return;
+    }
+    evaluateHeightRows(g, f, i0, i1 - i0 + 1, j0, j1);
+    g.pyramid.Update(g.heights, i0, j0, i1, j1);
+}
+
+// Rebuilds the whole grid for the current layout and storage settings
+static void rebuildHeightGrid(HeightGrid& g, const TerrainFeatureArrays& f) {
+    g.dim = terrainWorldQuads() + 1;
+    g.spacing = s_layout.spacing;
+    g.origin = -(terrainWorldQuads() / 2) * g.spacing;
+    g.compressed = g.dim >= s_heightStorage.compressFromDim;
+    g.valid = true;
+    if (g.compressed) {
+        // Built tile by tile, so the float grid never exists in full
+        g.heights.Clear();
+        g.pyramid.Clear();
+        const TerrainHeightStorage& st = s_heightStorage;
+        g.packed.Reset(g.dim, g.origin, g.spacing, st.tileSize, st.maxError, st.cachedTiles);
+        int tiles = g.packed.TilesPerSide();
+        ThreadPool::Shared().ParallelFor(0, tiles * tiles, [&g, &f, tiles](int t) {
+            encodeHeightTile(g, f, t % tiles, t / tiles);
+        });
+        return;
+    }
+    g.packed.Clear();
+    g.heights.Reset(g.dim, g.dim);
+    // Rows are independent; spread them over the pool so rebuild time scales with cores
+    evaluateHeightRows(g, f, 0, g.dim, 0, g.dim - 1);
+    g.pyramid.Build(g.heights, g.origin, g.spacing);
+}
+
+// Brings the edit copy up to date: ponds first, since the grid is evaluated from them
+static void syncEditGrid() {
+    syncEditFeatures();
+    HeightGrid& g = s_edit.grid;
+    if (!g.valid) rebuildHeightGrid(g, s_edit.features);
+    else for (const glm::vec4& r : s_dirtyRegions) updateHeightGridRegion(g, s_edit.features, r);
+    s_dirtyRegions.clear();
+}
+
+// What main-thread queries read: the edit copy, synced first (features only, unless withGrid)
+static inline const TerrainSnapshot& editSnapshot(bool withGrid) {
+    if (withGrid) {
+        if (s_featuresDirty || !s_edit.grid.valid || !s_dirtyRegions.empty()) syncEditGrid();
+    } else if (s_featuresDirty) {
+        syncEditFeatures();
+    }
+    return s_edit;
+}
+
+// What other threads read, inside an RcuReadScope: the snapshot their TerrainReadScope
+// pinned, or else the published one. Nothing is synced or published from here.
+static inline const TerrainSnapshot& sharedSnapshot() {
+    if (t_pinned) return *t_pinned;
+    const TerrainSnapshot* s = s_published.Read();
+    return s ? *s : s_noSnapshot;
+}
+
+// The snapshot height queries on this thread read
+static const TerrainSnapshot& readSnapshot(bool withGrid) {
+    return onEditThread() ? editSnapshot(withGrid) : sharedSnapshot();
 }
 
-// Base rolling hills + optional mountain domes (no pond deformation)
+const TerrainFeatureArrays& terrainFeatures() {
+    return readSnapshot(false).features;
+}
+
+void terrainPublish() {
+    syncEditGrid();
+    if (!s_publishPending) {
+        s_published.Reclaim();
+        return;
+    }
+    s_edit.revision = s_terrainRevision;
+    // Shares the grid's bands and tiles with the edit copy; later edits copy what they touch
+    s_published.Publish(std::make_unique<TerrainSnapshot>(s_edit));
+    s_publishPending = false;
+}
+
+void terrainUpdateHeightCache() {
+    terrainPublish();
+}
+
+TerrainReadScope::TerrainReadScope() : m_Outer(t_pinned) {
+    // The main thread reads its edit copy, which cannot change under its own reads
+    if (t_pinned || onEditThread()) return;
+    const TerrainSnapshot* s = s_published.Read();
+    t_pinned = s ? s : &s_noSnapshot;
+}
+
+TerrainReadScope::~TerrainReadScope() {
+    t_pinned = m_Outer;
+}
+
+unsigned TerrainReadScope::Revision() const {
+    return t_pinned ? t_pinned->revision : s_terrainRevision;
+}
+
+// Both are the layer stack of terrain/TerrainLayers.h, evaluated at one point
 float getTerrainBaseHeight(float x, float z) {
-    // Base gentle hills
-    float y = 0.5f * std::sin(x * 0.2f) * std::cos(z * 0.2f);
+    RcuReadScope scope;
+    return terrainLayerHeight(terrainFeatures(), x, z, TerrainLayers::Base);
+}
 
-    // Add mountains with smooth dome falloff
-    for (const auto& m : s_mountains) {
-        float dx = x - m.center.x;
-        float dz = z - m.center.y;
-        float dist = std::sqrt(dx*dx + dz*dz);
-        if (dist < m.radius) {
-            float t = 1.0f - (dist / m.radius); // 1 at center -> 0 at edge
-            y += m.height * (t * t);            // quadratic falloff
+float getTerrainHeightExact(float x, float z) {
+    RcuReadScope scope;
+    return terrainLayerHeight(terrainFeatures(), x, z, TerrainLayers::Full);
+}
+
+const float* terrainHeightCache(int& dim, float& origin, float& spacing) {
+    syncEditGrid();
+    const HeightGrid& g = s_edit.grid;
+    dim = g.dim;
+    origin = g.origin;
+    spacing = g.spacing;
+    if (g.compressed) {
+        g.packed.Decode(s_gridCopy);
+    } else {
+        s_gridCopy.resize((size_t)g.dim * g.dim);
+        g.heights.CopyTo(s_gridCopy.data());
+    }
+    return s_gridCopy.data();
+}
+
+void terrainSetHeightStorage(const TerrainHeightStorage& storage) {
+    s_heightStorage = storage;
+    // Quantization shifts the cached heights slightly, so whatever was built from them is
+    // rebuilt along with the grid
+    terrainInvalidateHeightCache();
+}
+
+TerrainHeightStorageStats terrainHeightStorageStats() {
+    const HeightGrid& g = s_edit.grid;
+    TerrainHeightStorageStats stats;
+    stats.compressed = g.compressed;
+    stats.dim = g.dim;
+    stats.floatBytes = (size_t)g.dim * g.dim * sizeof(float);
+    if (!g.compressed) {
+        stats.storedBytes = (size_t)g.heights.Width() * g.heights.Height() * sizeof(float);
+        return stats;
+    }
+    TerrainCompressedHeights::Stats p = g.packed.GetStats();
+    stats.storedBytes = p.encodedBytes;
+    stats.decodedBytes = p.decodedBytes;
+    stats.tiles = p.tiles;
+    stats.tiles8Bit = p.tiles8Bit;
+    stats.cacheHits = p.hits;
+    stats.cacheMisses = p.misses;
+    return stats;
+}
+
+bool terrainLoadHeightCache(const float* heights, int dim, float origin, float spacing) {
+    if (dim != terrainWorldQuads() + 1 || spacing != s_layout.spacing ||
+        origin != -(terrainWorldQuads() / 2) * s_layout.spacing) return false;
+    // Everything built from the previous grid is out of date, but the grid itself is not
+    const float inf = std::numeric_limits<float>::infinity();
+    recordEdit(-inf, -inf, inf, inf);
+    HeightGrid& g = s_edit.grid;
+    g.dim = dim;
+    g.origin = origin;
+    g.spacing = spacing;
+    g.valid = true;
+    s_dirtyRegions.clear();
+    g.compressed = dim >= s_heightStorage.compressFromDim;
+    if (g.compressed) {
+        g.heights.Clear();
+        g.pyramid.Clear();
+        const TerrainHeightStorage& st = s_heightStorage;
+        g.packed.Reset(dim, origin, spacing, st.tileSize, st.maxError, st.cachedTiles);
+        int tiles = g.packed.TilesPerSide();
+        ThreadPool::Shared().ParallelFor(0, tiles * tiles, [&g, heights, tiles](int t) {
+            int i0, j0, n;
+            g.packed.TileSamples(t % tiles, t / tiles, i0, j0, n);
+            std::vector<float> samples((size_t)n * n);
+            for (int j = 0; j < n; ++j)
+                for (int i = 0; i < n; ++i) {
+                    int si = std::min(i0 + i, g.dim - 1), sj = std::min(j0 + j, g.dim - 1);
+                    samples[(size_t)j * n + i] = heights[(size_t)sj * g.dim + si];
+                }
+            g.packed.EncodeTile(t % tiles, t / tiles, samples.data());
+        });
+    } else {
+        g.packed.Clear();
+        g.heights.Reset(dim, dim);
+        for (int j = 0; j < dim; ++j)
+            std::copy(heights + (size_t)j * dim, heights + (size_t)(j + 1) * dim, g.heights.MutableRow(j));
+        g.pyramid.Build(g.heights, origin, spacing);
+    }
+    terrainPublish();
+    return true;
+}
+
+// Grid coordinates of (x, z); false off the grid, for NaNs, and while there is no grid
+static inline bool onGrid(const HeightGrid& g, float x, float z, float& gx, float& gz) {
+    gx = (x - g.origin) / g.spacing;
+    gz = (z - g.origin) / g.spacing;
+    return g.valid && gx >= 0.0f && gz >= 0.0f && gx <= g.dim - 1 && gz <= g.dim - 1;
+}
+
+// Bilinear height at grid coordinates (gx, gz) of a plain float grid; the point must lie on it
+static inline float gridHeight(const HeightGrid& g, float gx, float gz) {
+    int i = std::min((int)gx, g.dim - 2);
+    int j = std::min((int)gz, g.dim - 2);
+    float fx = gx - i;
+    float fz = gz - j;
+    const float* row0 = g.heights.Row(j) + i;
+    const float* row1 = g.heights.Row(j + 1) + i;
+    float h0 = row0[0] + (row0[1] - row0[0]) * fx;
+    float h1 = row1[0] + (row1[1] - row1[0]) * fx;
+    return h0 + (h1 - h0) * fz;
+}
+
+void getTerrainHeightBatch(const float* xs, const float* zs, float* out, size_t n) {
+    // One snapshot (and on the main thread one sync) for the whole batch
+    RcuReadScope scope;
+    const TerrainSnapshot& s = readSnapshot(true);
+    const HeightGrid& g = s.grid;
+    // Grid points are looked up in place; the rest are gathered for one exact SIMD pass.
+    // The gather lists are per thread so meshing a chunk allocates nothing once warmed up.
+    static thread_local std::vector<float> offX, offZ, offY;
+    static thread_local std::vector<size_t> offIndex;
+    offX.clear();
+    offZ.clear();
+    offIndex.clear();
+    for (size_t k = 0; k < n; ++k) {
+        float gx, gz;
+        if (onGrid(g, xs[k], zs[k], gx, gz)) {
+            out[k] = g.compressed ? g.packed.HeightAt(xs[k], zs[k]) : gridHeight(g, gx, gz);
+        } else {
+            offX.push_back(xs[k]);
+            offZ.push_back(zs[k]);
+            offIndex.push_back(k);
         }
     }
-    return y;
+    if (offIndex.empty()) return;
+    offY.resize(offIndex.size());
+    terrainLayerHeightBatch(s.features, offX.data(), offZ.data(), offY.data(), offIndex.size());
+    for (size_t k = 0; k < offIndex.size(); ++k) out[offIndex[k]] = offY[k];
+}
+
+static inline float heightIn(const TerrainSnapshot& s, float x, float z) {
+    float gx, gz;
+    // Off-grid queries (and NaNs) take the exact path
+    if (!onGrid(s.grid, x, z, gx, gz)) return terrainLayerHeight(s.features, x, z, TerrainLayers::Full);
+    if (s.grid.compressed) return s.grid.packed.HeightAt(x, z);
+    return gridHeight(s.grid, gx, gz);
 }
 
-// Final terrain height including pond basins carved out of the base terrain
 float getTerrainHeight(float x, float z) {
-    float y = getTerrainBaseHeight(x, z);
-    // Carve pond basins so water sits in a depression instead of following slopes
-    const auto &ponds = getPonds();
-    for (const auto &pp : ponds) {
-        const glm::vec2 &c = pp.first;
-        float r = pp.second;
-        float dx = x - c.x;
-        float dz = z - c.y;
-        float dist = std::sqrt(dx*dx + dz*dz);
-        if (dist < r) {
-            // compute a center base height and a max depth proportional to radius
-            float centerBase = getTerrainBaseHeight(c.x, c.y);
-            float maxDepth = std::min(3.0f, r * 0.35f);
-            float falloff = 1.0f - (dist / r);
-            float depress = maxDepth * (falloff * falloff);
-            float depressedY = centerBase - depress;
-            if (y > depressedY) y = depressedY;
+    // The edit copy only changes on this same thread, so the main thread needs no read scope
+    if (onEditThread()) return heightIn(editSnapshot(true), x, z);
+    RcuReadScope scope;
+    return heightIn(sharedSnapshot(), x, z);
+}
+
+// Steps along the ray sampling getTerrainHeight and bisects the first crossing. Used for
+// the parts of a ray outside the cached grid, where there is no pyramid.
+static bool marchTerrainRay(const glm::vec3& o, const glm::vec3& d, float t0, float t1, float& tHit) {
+    auto above = [&](float t) {
+        glm::vec3 p = o + d * t;
+        return p.y - getTerrainHeight(p.x, p.z);
+    };
+    if (above(t0) <= 0.0f) { tHit = t0; return true; }
+    float horizontal = std::sqrt(d.x * d.x + d.z * d.z);
+    float dt = 0.5f * s_layout.spacing / std::max(horizontal, 1e-3f);
+    float prev = t0;
+    for (float t = std::min(t0 + dt, t1); ; t = std::min(t + dt, t1)) {
+        if (above(t) <= 0.0f) {
+            float lo = prev, hi = t;
+            for (int k = 0; k < 20; ++k) {
+                float mid = 0.5f * (lo + hi);
+                if (above(mid) <= 0.0f) hi = mid; else lo = mid;
+            }
+            tHit = hi;
+            return true;
         }
+        if (t >= t1) return false;
+        prev = t;
     }
-    return y;
+}
+
+bool terrainRaycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& tHit) {
+    // Pinned, so the pyramid walk and the marches around it all read the same snapshot
+    TerrainReadScope scope;
+    const HeightGrid& g = readSnapshot(true).grid;
+    if (!(maxT >= 0.0f)) return false;
+    const TerrainHeightPyramid& p = g.pyramid;
+    // Split the ray into the span over the cached grid and whatever lies before/after it
+    float g0 = 0.0f, g1 = maxT;
+    bool overGrid = !p.Empty();
+    auto slab = [&](float o, float d) {
+        if (std::fabs(d) < 1e-12f) {
+            if (o < p.MinCoord() || o > p.MaxCoord()) overGrid = false;
+            return;
+        }
+        float a = (p.MinCoord() - o) / d, b = (p.MaxCoord() - o) / d;
+        if (a > b) std::swap(a, b);
+        g0 = std::max(g0, a);
+        g1 = std::min(g1, b);
+    };
+    slab(origin.x, dir.x);
+    slab(origin.z, dir.z);
+    if (!overGrid || g0 > g1) return marchTerrainRay(origin, dir, 0.0f, maxT, tHit);
+
+    if (g0 > 0.0f && marchTerrainRay(origin, dir, 0.0f, g0, tHit)) return true;
+    if (p.Raycast(g.heights, origin, dir, g0, g1, tHit)) return true;
+    return g1 < maxT && marchTerrainRay(origin, dir, g1, maxT, tHit);
 }
 
 // Return strongest mountain influence [0..1] at (x,z)
-static float getMountainContribution(float x, float z) {
+float getMountainContribution(float x, float z) {
     float best = 0.0f;
-    for (const auto& m : s_mountains) {
-        float dx = x - m.center.x;
-        float dz = z - m.center.y;
+    RcuReadScope scope;
+    const TerrainFeatureArrays& f = terrainFeatures();
+    const std::vector<uint32_t>* cell = f.mountainIndex.CellAt(x, z);
+    if (!cell) return best;
+    for (uint32_t k : *cell) {
+        float dx = x - f.mountainX[k];
+        float dz = z - f.mountainZ[k];
         float dist = std::sqrt(dx*dx + dz*dz);
-        if (dist < m.radius) {
-            float t = 1.0f - (dist / m.radius);
+        if (dist < f.mountainRadius[k]) {
+            float t = 1.0f - (dist / f.mountainRadius[k]);
             if (t > best) best = t; // keep max influence
         }
     }
     return best;
 }
 
-void drawTerrain() {
-    // Grid size (SIZE x SIZE) and spacing between vertices
-    const int SIZE = 120;        // Optimized for smooth performance
-    const float SPACING = 0.75f; // Increased spacing to cover same area
-
-    glShadeModel(GL_SMOOTH);
-    glBegin(GL_QUADS);
-    for (int i = -SIZE/2; i < SIZE/2; ++i) {
-        for (int j = -SIZE/2; j < SIZE/2; ++j) {
-            float x1 = i * SPACING;
-            float z1 = j * SPACING;
-            float x2 = (i + 1) * SPACING;
-            float z2 = (j + 1) * SPACING;
-
-            float y11 = getTerrainHeight(x1, z1);
-            float y12 = getTerrainHeight(x1, z2);
-            float y21 = getTerrainHeight(x2, z1);
-            float y22 = getTerrainHeight(x2, z2);
-
-            // Simple color variation by average height and mountain contribution
-            float avg = (y11 + y12 + y21 + y22) * 0.25f;
-            // Compute mountain influence per-vertex and take the max for the quad
-            float m11 = getMountainContribution(x1, z1);
-            float m12 = getMountainContribution(x1, z2);
-            float m21 = getMountainContribution(x2, z1);
-            float m22 = getMountainContribution(x2, z2);
-            float m = std::max(std::max(m11, m12), std::max(m21, m22));
-
-            // Colors
-            const float greenR = 0.05f, greenG = 0.45f, greenB = 0.05f;
-            const float brownR = 0.45f, brownG = 0.30f, brownB = 0.18f;
-            const float peakR = 0.95f, peakG = 0.95f, peakB = 0.95f;
-
-            float r,g,b;
-            if (m > 0.0f) {
-                // Mountain area: fully brown body (no green blending)
-                float mixMB = std::clamp(m, 0.0f, 1.0f);
-                r = brownR;
-                g = brownG;
-                b = brownB;
-
-                // Peak: blend toward white for strongest influence
-                if (m > 0.65f) {
-                    float tpeak = (m - 0.65f) / (1.0f - 0.65f); // 0..1
-                    r = r * (1.0f - tpeak) + peakR * tpeak;
-                    g = g * (1.0f - tpeak) + peakG * tpeak;
-                    b = b * (1.0f - tpeak) + peakB * tpeak;
-                }
-            } else {
-                // Non-mountain grassy color varied by height
-                float color = std::clamp(0.35f + avg * 0.1f, 0.05f, 0.9f);
-                r = greenR * color;
-                g = greenG * color;
-                b = greenB * color;
-            }
-            glColor3f(r, g, b);
+// Terrain colour from height and mountain influence: brown mountain body blending to white
+// peaks, height-tinted grass elsewhere
+glm::vec3 terrainColor(float height, float m) {
+    const glm::vec3 green(0.05f, 0.45f, 0.05f);
+    const glm::vec3 brown(0.45f, 0.30f, 0.18f);
+    const glm::vec3 peak(0.95f, 0.95f, 0.95f);
 
-            glVertex3f(x1, y11, z1);
-            glVertex3f(x2, y21, z1);
-            glVertex3f(x2, y22, z2);
-            glVertex3f(x1, y12, z2);
+    if (m > 0.0f) {
+        // Mountain area: fully brown body (no green blending)
+        glm::vec3 c = brown;
+        // Peak: blend toward white for strongest influence
+        if (m > 0.65f) {
+            float tpeak = (m - 0.65f) / (1.0f - 0.65f); // 0..1
+            c = c * (1.0f - tpeak) + peak * tpeak;
         }
+        return c;
     }
-    glEnd();
-}
\ No newline at end of file
+    // Non-mountain grassy color varied by height
+    float color = std::clamp(0.35f + height * 0.1f, 0.05f, 0.9f);
+    return green * color;
+}
+
+void drawTerrain(const glm::vec3& eye, const glm::vec3& focus, const Frustum* frustum) {
+    s_terrainQuadtree.Draw(eye, focus, frustum);
+}
+
+void terrainSetStreaming(const TerrainStreaming& streaming) {
+    s_streaming = streaming;
+    s_terrainQuadtree.SetRingRadius(streaming.ringRadius);
+    s_terrainQuadtree.SetMemoryBudget(streaming.memoryBudget);
+    s_terrainQuadtree.SetCompactVertices(streaming.compactVertices);
+}
+
+const TerrainStreaming& terrainGetStreaming() {
+    return s_streaming;
+}
+
+TerrainResidencyStats terrainResidencyStats() {
+    return s_terrainQuadtree.Stats();
+}
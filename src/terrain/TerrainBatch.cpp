@@ -0,0 +1,114 @@
+// Exact terrain height evaluation: the built-in layer stack (terrain/TerrainLayers.h),
+// instantiated per lane width for getTerrainHeightExactBatch and dispatched on the running
+// CPU, and with float for the scalar queries.
+
+// The layer stacks are instantiated over the lane types here and only ever inlined into the
+// target-attributed entry points below, so GCC's vector ABI notes do not apply to this file
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#include "../../include/terrain.h"
+#include "../../include/terrain/TerrainFeatures.h"
+#include "../../include/terrain/TerrainLayers.h"
+#include "../../include/core/Rcu.h"
+#include <algorithm>
+#include <vector>
+
+using namespace simd;
+
+// Calls run.Go<Stack>() with the built-in stack for the snapshot's base surface (heightmap,
+// noise or hills), erosion when requested, then the Top layers. Resolved once per call, so
+// the chosen stack runs as one fused kernel.
+template<class... Top, class Run>
+SIMD_INLINE auto withTerrainStack(const TerrainFeatureArrays& f, bool erosion, Run& run) {
+    if (erosion) {
+        if (f.heightmap) return run.template Go<TerrainLayerStack<TerrainHeightmapLayer, TerrainErosionLayer, Top...>>();
+        if (f.noise) return run.template Go<TerrainLayerStack<TerrainNoiseLayer, TerrainErosionLayer, Top...>>();
+        return run.template Go<TerrainLayerStack<TerrainHillsLayer, TerrainErosionLayer, Top...>>();
+    }
+    if (f.heightmap) return run.template Go<TerrainLayerStack<TerrainHeightmapLayer, Top...>>();
+    if (f.noise) return run.template Go<TerrainLayerStack<TerrainNoiseLayer, Top...>>();
+    return run.template Go<TerrainLayerStack<TerrainHillsLayer, Top...>>();
+}
+
+struct PointRun {
+    const TerrainFeatureArrays& f;
+    float x, z;
+
+    template<class Stack>
+    float Go() {
+        Stack stack;
+        stack.Bind(f);
+        return stack.HeightAt(x, z);
+    }
+};
+
+float terrainLayerHeight(const TerrainFeatureArrays& f, float x, float z, TerrainLayers layers) {
+    PointRun run{ f, x, z };
+    switch (layers) {
+        case TerrainLayers::Surface: return withTerrainStack<>(f, false, run);
+        case TerrainLayers::Base: return withTerrainStack<TerrainDomeLayer>(f, f.erosion != nullptr, run);
+        default: return withTerrainStack<TerrainDomeLayer, TerrainBasinLayer>(f, f.erosion != nullptr, run);
+    }
+}
+
+template<class V>
+struct BatchRun {
+    const float* xs;
+    const float* zs;
+    float* out;
+    size_t n;
+    const TerrainFeatureArrays& f;
+
+    template<class Stack>
+    SIMD_INLINE void Go() {
+        // Kept per thread so the feature id lists keep their capacity between calls
+        static thread_local Stack stack;
+        stack.Bind(f);
+        stack.template Evaluate<V>(xs, zs, out, n);
+    }
+};
+
+template<class V>
+SIMD_INLINE void terrainHeightKernel(const float* xs, const float* zs, float* out, size_t n,
+                                     const TerrainFeatureArrays& f) {
+    BatchRun<V> run{ xs, zs, out, n, f };
+    withTerrainStack<TerrainDomeLayer, TerrainBasinLayer>(f, f.erosion != nullptr, run);
+}
+
+static void heightsGeneric(const float* xs, const float* zs, float* out, size_t n, const TerrainFeatureArrays& f) {
+    terrainHeightKernel<f4>(xs, zs, out, n, f);
+}
+
+#if SIMD_HAS_X86_DISPATCH
+SIMD_TARGET_AVX2
+static void heightsAVX2(const float* xs, const float* zs, float* out, size_t n, const TerrainFeatureArrays& f) {
+    terrainHeightKernel<f8>(xs, zs, out, n, f);
+}
+
+SIMD_TARGET_AVX512
+static void heightsAVX512(const float* xs, const float* zs, float* out, size_t n, const TerrainFeatureArrays& f) {
+    terrainHeightKernel<f16>(xs, zs, out, n, f);
+}
+#endif
+
+typedef void (*HeightBatchFn)(const float*, const float*, float*, size_t, const TerrainFeatureArrays&);
+
+static HeightBatchFn pickHeightBatch() {
+#if SIMD_HAS_X86_DISPATCH
+    if (cpuHasAVX512()) return heightsAVX512;
+    if (cpuHasAVX2()) return heightsAVX2;
+#endif
+    return heightsGeneric;
+}
+
+void terrainLayerHeightBatch(const TerrainFeatureArrays& f, const float* xs, const float* zs, float* out, size_t n) {
+    static const HeightBatchFn fn = pickHeightBatch();
+    fn(xs, zs, out, n, f);
+}
+
+void getTerrainHeightExactBatch(const float* xs, const float* zs, float* out, size_t n) {
+    RcuReadScope scope;
+    terrainLayerHeightBatch(terrainFeatures(), xs, zs, out, n);
+}
@@ -0,0 +1,252 @@
+#include "../../include/terrain/TerrainCompressedHeights.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+static std::atomic<uint64_t> s_nextTileId{ 1 };
+
+// Hit and miss counts of one thread's decoded-tile LRU. Only the owning thread writes them,
+// so bumping is a plain load and store; GetStats reads them from any thread.
+struct TileCacheCounters {
+    std::atomic<unsigned long long> hits{ 0 };
+    std::atomic<unsigned long long> misses{ 0 };
+    std::atomic<size_t> decodedBytes{ 0 };
+};
+
+static void bump(std::atomic<unsigned long long>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Counters of the threads that have a cache, plus the totals of those that have exited.
+// Never destroyed: pool workers can exit after static destructors have run.
+struct TileCacheRegistry {
+    std::mutex mutex;
+    std::vector<const TileCacheCounters*> live;
+    unsigned long long exitedHits = 0;
+    unsigned long long exitedMisses = 0;
+};
+
+static TileCacheRegistry& tileCacheRegistry() {
+    static TileCacheRegistry* registry = new TileCacheRegistry;
+    return *registry;
+}
+
+// One thread's decoded tiles. Tile ids are never reused, so entries need no invalidation:
+// a re-encoded tile simply misses and its old entry ages out.
+struct DecodedTileCache {
+    struct Slot {
+        uint64_t id = 0; // 0 = empty
+        unsigned long long lastUse = 0;
+        std::vector<float> samples;
+    };
+    std::vector<Slot> slots;
+    int last = -1; // slot of the previous lookup, tried first
+    unsigned long long clock = 0;
+    TileCacheCounters counters;
+
+    DecodedTileCache() {
+        TileCacheRegistry& r = tileCacheRegistry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(&counters);
+    }
+    ~DecodedTileCache() {
+        TileCacheRegistry& r = tileCacheRegistry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), &counters));
+        r.exitedHits += counters.hits.load();
+        r.exitedMisses += counters.misses.load();
+    }
+};
+
+static thread_local DecodedTileCache t_tileCache;
+
+void TerrainCompressedHeights::Clear() {
+    m_Tiles.clear();
+    m_Tiles.shrink_to_fit();
+    m_TilesPerSide = 0;
+    m_Dim = 0;
+}
+
+void TerrainCompressedHeights::Reset(int dim, float origin, float spacing, int tileSize, float maxError,
+                                     int cachedTiles) {
+    Clear();
+    if (dim < 2) return;
+    m_Dim = dim;
+    m_Origin = origin;
+    m_Spacing = spacing;
+    m_TileSize = std::max(tileSize, 2);
+    m_MaxError = maxError;
+    m_TilesPerSide = (dim - 1 + m_TileSize - 1) / m_TileSize;
+    m_Tiles.assign((size_t)m_TilesPerSide * m_TilesPerSide, nullptr);
+    m_CachedTiles = std::max(cachedTiles, 4);
+}
+
+void TerrainCompressedHeights::TileSamples(int tx, int tz, int& i0, int& j0, int& n) const {
+    i0 = tx * m_TileSize;
+    j0 = tz * m_TileSize;
+    n = m_TileSize + 1;
+}
+
+void TerrainCompressedHeights::TilesCovering(int i0, int j0, int i1, int j1, int& tx0, int& tz0, int& tx1,
+                                             int& tz1) const {
+    const int last = m_TilesPerSide - 1;
+    tx0 = std::clamp((i0 - 1) / m_TileSize, 0, last);
+    tz0 = std::clamp((j0 - 1) / m_TileSize, 0, last);
+    tx1 = std::clamp(i1 / m_TileSize, 0, last);
+    tz1 = std::clamp(j1 / m_TileSize, 0, last);
+}
+
+void TerrainCompressedHeights::EncodeTile(int tx, int tz, const float* samples) {
+    const int n = m_TileSize + 1;
+    int i0, j0, unused;
+    TileSamples(tx, tz, i0, j0, unused);
+    // Samples past the grid edge are padded with the last real one, so they never widen
+    // the range
+    const int ni = std::min(n, m_Dim - i0), nj = std::min(n, m_Dim - j0);
+    auto at = [&](int i, int j) { return samples[(size_t)std::min(j, nj - 1) * n + std::min(i, ni - 1)]; };
+
+    float lo = at(0, 0), hi = lo;
+    for (int j = 0; j < nj; ++j) {
+        for (int i = 0; i < ni; ++i) {
+            lo = std::min(lo, at(i, j));
+            hi = std::max(hi, at(i, j));
+        }
+    }
+    auto next = std::make_shared<Tile>();
+    Tile& tile = *next;
+    // Rounding to the nearest step errs by at most half a step
+    tile.bits = (hi - lo) / 255.0f * 0.5f <= m_MaxError ? 8 : 12;
+    const float levels = tile.bits == 8 ? 255.0f : 4095.0f;
+    tile.minH = lo;
+    tile.step = (hi - lo) / levels;
+    const float toSteps = tile.step > 0.0f ? 1.0f / tile.step : 0.0f;
+    const size_t count = (size_t)n * n;
+    tile.data.assign(tile.bits == 8 ? count : (count * 3 + 1) / 2, 0);
+    for (size_t k = 0; k < count; ++k) {
+        float v = at((int)(k % n), (int)(k / n));
+        uint32_t q = (uint32_t)std::lround(std::clamp((v - lo) * toSteps, 0.0f, levels));
+        if (tile.bits == 8) {
+            tile.data[k] = (uint8_t)q;
+        } else {
+            // Two 12-bit values per three bytes
+            size_t b = (k >> 1) * 3;
+            if (k & 1) {
+                tile.data[b + 1] |= (uint8_t)((q & 0xF) << 4);
+                tile.data[b + 2] = (uint8_t)(q >> 4);
+            } else {
+                tile.data[b] = (uint8_t)(q & 0xFF);
+                tile.data[b + 1] = (uint8_t)(q >> 8);
+            }
+        }
+    }
+    tile.id = s_nextTileId.fetch_add(1);
+    m_Tiles[(size_t)tz * m_TilesPerSide + tx] = std::move(next);
+}
+
+void TerrainCompressedHeights::decodeTile(const Tile& tile, float* out) const {
+    const size_t count = (size_t)(m_TileSize + 1) * (m_TileSize + 1);
+    const uint8_t* d = tile.data.data();
+    if (tile.bits == 8) {
+        for (size_t k = 0; k < count; ++k) out[k] = tile.minH + d[k] * tile.step;
+        return;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        const uint8_t* b = d + (k >> 1) * 3;
+        uint32_t q = (k & 1) ? (uint32_t)(b[1] >> 4) | ((uint32_t)b[2] << 4)
+                             : (uint32_t)b[0] | ((uint32_t)(b[1] & 0xF) << 8);
+        out[k] = tile.minH + q * tile.step;
+    }
+}
+
+const float* TerrainCompressedHeights::cachedTile(const Tile& tile) const {
+    DecodedTileCache& c = t_tileCache;
+    if (c.last >= 0 && c.slots[c.last].id == tile.id) {
+        // Neighbouring lookups mostly land in the same tile
+        bump(c.counters.hits);
+        c.slots[c.last].lastUse = ++c.clock;
+        return c.slots[c.last].samples.data();
+    }
+    // A linear scan; there are only a few dozen slots
+    int s = -1, oldest = 0;
+    for (int k = 0; k < (int)c.slots.size(); ++k) {
+        if (c.slots[k].id == tile.id) { s = k; break; }
+        if (c.slots[k].lastUse < c.slots[oldest].lastUse) oldest = k;
+    }
+    if (s >= 0) {
+        bump(c.counters.hits);
+    } else {
+        bump(c.counters.misses);
+        if ((int)c.slots.size() < m_CachedTiles) {
+            s = (int)c.slots.size();
+            c.slots.emplace_back();
+        } else {
+            s = oldest;
+        }
+        DecodedTileCache::Slot& slot = c.slots[s];
+        size_t before = slot.samples.size();
+        slot.id = tile.id;
+        slot.samples.resize((size_t)(m_TileSize + 1) * (m_TileSize + 1));
+        decodeTile(tile, slot.samples.data());
+        c.counters.decodedBytes.store(c.counters.decodedBytes.load(std::memory_order_relaxed) +
+                                      (slot.samples.size() - before) * sizeof(float), std::memory_order_relaxed);
+    }
+    c.last = s;
+    c.slots[s].lastUse = ++c.clock;
+    return c.slots[s].samples.data();
+}
+
+float TerrainCompressedHeights::HeightAt(float x, float z) const {
+    float gx = (x - m_Origin) / m_Spacing;
+    float gz = (z - m_Origin) / m_Spacing;
+    int i = std::clamp((int)gx, 0, m_Dim - 2);
+    int j = std::clamp((int)gz, 0, m_Dim - 2);
+    int tx = i / m_TileSize, tz = j / m_TileSize;
+    const float* t = cachedTile(*m_Tiles[(size_t)tz * m_TilesPerSide + tx]);
+    const int n = m_TileSize + 1;
+    float fx = gx - i, fz = gz - j;
+    const float* row0 = t + (size_t)(j - tz * m_TileSize) * n + (i - tx * m_TileSize);
+    const float* row1 = row0 + n;
+    float h0 = row0[0] + (row0[1] - row0[0]) * fx;
+    float h1 = row1[0] + (row1[1] - row1[0]) * fx;
+    return h0 + (h1 - h0) * fz;
+}
+
+void TerrainCompressedHeights::HeightBatch(const float* xs, const float* zs, float* out, size_t n) const {
+    for (size_t k = 0; k < n; ++k) out[k] = HeightAt(xs[k], zs[k]);
+}
+
+void TerrainCompressedHeights::Decode(std::vector<float>& out) const {
+    out.resize((size_t)m_Dim * m_Dim);
+    const int n = m_TileSize + 1;
+    std::vector<float> tile((size_t)n * n);
+    for (int tz = 0; tz < m_TilesPerSide; ++tz) {
+        for (int tx = 0; tx < m_TilesPerSide; ++tx) {
+            decodeTile(*m_Tiles[(size_t)tz * m_TilesPerSide + tx], tile.data());
+            int i0 = tx * m_TileSize, j0 = tz * m_TileSize;
+            int ni = std::min(n, m_Dim - i0), nj = std::min(n, m_Dim - j0);
+            for (int j = 0; j < nj; ++j)
+                std::copy(&tile[(size_t)j * n], &tile[(size_t)j * n] + ni, &out[(size_t)(j0 + j) * m_Dim + i0]);
+        }
+    }
+}
+
+TerrainCompressedHeights::Stats TerrainCompressedHeights::GetStats() const {
+    Stats stats;
+    stats.tiles = m_Tiles.size();
+    for (const auto& t : m_Tiles) {
+        if (!t) continue;
+        if (t->bits == 8) ++stats.tiles8Bit;
+        stats.encodedBytes += sizeof(Tile) + t->data.size();
+    }
+    TileCacheRegistry& r = tileCacheRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    stats.hits = r.exitedHits;
+    stats.misses = r.exitedMisses;
+    for (const TileCacheCounters* c : r.live) {
+        stats.hits += c->hits.load(std::memory_order_relaxed);
+        stats.misses += c->misses.load(std::memory_order_relaxed);
+        stats.decodedBytes += c->decodedBytes.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
@@ -0,0 +1,260 @@
+#include "../../include/terrain/TerrainErosion.h"
+#include "../../include/core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const char EROSION_MAGIC[8] = { 'T', 'E', 'R', 'R', 'E', 'R', 'O', 'D' };
+static const uint32_t EROSION_VERSION = 1;
+
+struct ErosionFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t dim;
+    uint64_t key;
+    float origin, spacing;
+};
+
+// Each round runs a share of the droplets in every tile, so the erosion builds up evenly
+// across tile borders instead of one tile at a time
+static const int EROSION_ROUNDS = 8;
+
+// Per-tile random stream (splitmix64), seeded from the tile and round so droplet paths do
+// not depend on which thread runs the tile
+struct ErosionRng {
+    uint64_t state;
+
+    float Next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        return (float)(z >> 40) * (1.0f / 16777216.0f); // [0, 1)
+    }
+};
+
+// Area a droplet may move in, in sample units: x in [x0, x1), z in [z0, z1)
+struct DropletBounds {
+    float x0, z0, x1, z1;
+};
+
+static float sampleBilinear(const std::vector<float>& h, int dim, float x, float z) {
+    int ci = (int)x, cj = (int)z;
+    float fx = x - ci, fz = z - cj;
+    const float* row0 = &h[(size_t)cj * dim + ci];
+    const float* row1 = row0 + dim;
+    float a = row0[0] + (row0[1] - row0[0]) * fx;
+    float b = row1[0] + (row1[1] - row1[0]) * fx;
+    return a + (b - a) * fz;
+}
+
+static void runDroplet(std::vector<float>& h, int dim, const TerrainErosion& p, float x, float z,
+                       const DropletBounds& bounds) {
+    float dirX = 0.0f, dirZ = 0.0f, speed = 1.0f, water = 1.0f, sediment = 0.0f;
+    for (int step = 0; step < p.dropletLifetime; ++step) {
+        int ci = (int)x, cj = (int)z;
+        float fx = x - ci, fz = z - cj;
+        size_t k = (size_t)cj * dim + ci;
+        float h00 = h[k], h10 = h[k + 1], h01 = h[k + dim], h11 = h[k + dim + 1];
+        float height = h00 * (1.0f - fx) * (1.0f - fz) + h10 * fx * (1.0f - fz) +
+                       h01 * (1.0f - fx) * fz + h11 * fx * fz;
+        float gx = (h10 - h00) * (1.0f - fz) + (h11 - h01) * fz;
+        float gz = (h01 - h00) * (1.0f - fx) + (h11 - h10) * fx;
+
+        dirX = dirX * p.inertia - gx * (1.0f - p.inertia);
+        dirZ = dirZ * p.inertia - gz * (1.0f - p.inertia);
+        float len = std::sqrt(dirX * dirX + dirZ * dirZ);
+        if (len < 1e-6f) break; // flat: nowhere to flow
+        dirX /= len;
+        dirZ /= len;
+        float nx = x + dirX, nz = z + dirZ;
+        if (nx < bounds.x0 || nz < bounds.z0 || nx >= bounds.x1 || nz >= bounds.z1) break;
+
+        float dh = sampleBilinear(h, dim, nx, nz) - height;
+        float capacity = std::max(-dh * speed * water * p.sedimentCapacity, p.minSedimentCapacity);
+        // Sediment goes to (or comes from) the four corners of the cell the droplet leaves
+        float amount;
+        if (sediment > capacity || dh > 0.0f) {
+            // Uphill: fill the pit behind it; otherwise drop the excess
+            amount = dh > 0.0f ? std::min(dh, sediment) : (sediment - capacity) * p.depositSpeed;
+            sediment -= amount;
+        } else {
+            // Never dig deeper than the drop ahead, or droplets carve spikes
+            amount = -std::min((capacity - sediment) * p.erodeSpeed, -dh);
+            sediment -= amount;
+        }
+        h[k] += amount * (1.0f - fx) * (1.0f - fz);
+        h[k + 1] += amount * fx * (1.0f - fz);
+        h[k + dim] += amount * (1.0f - fx) * fz;
+        h[k + dim + 1] += amount * fx * fz;
+
+        speed = std::sqrt(std::max(speed * speed - dh * p.gravity, 0.0f));
+        water *= 1.0f - p.evaporateSpeed;
+        x = nx;
+        z = nz;
+    }
+}
+
+static void erodeHydraulic(std::vector<float>& h, int dim, const TerrainErosion& p, ThreadPool& pool) {
+    const int cells = dim - 1;
+    const int ts = std::max(p.tileSize, 4);
+    const int tiles = (cells + ts - 1) / ts;
+    // Tiles run together are two tiles apart, so growing each by under half a tile keeps
+    // their droplet areas (and the samples they touch) disjoint
+    const int margin = (ts - 1) / 2;
+    const int perTileRound = (p.droplets + tiles * tiles * EROSION_ROUNDS - 1) / (tiles * tiles * EROSION_ROUNDS);
+
+    std::vector<int> batch;
+    for (int round = 0; round < EROSION_ROUNDS; ++round) {
+        for (int pass = 0; pass < 4; ++pass) {
+            batch.clear();
+            for (int tz = pass >> 1; tz < tiles; tz += 2)
+                for (int tx = pass & 1; tx < tiles; tx += 2) batch.push_back(tz * tiles + tx);
+            pool.ParallelFor(0, (int)batch.size(), [&](int b) {
+                int tile = batch[b];
+                int tx = tile % tiles, tz = tile / tiles;
+                int x0 = tx * ts, z0 = tz * ts;
+                int x1 = std::min(x0 + ts, cells), z1 = std::min(z0 + ts, cells);
+                DropletBounds bounds{ (float)std::max(x0 - margin, 0), (float)std::max(z0 - margin, 0),
+                                      (float)std::min(x1 + margin, cells), (float)std::min(z1 + margin, cells) };
+                ErosionRng rng{ ((uint64_t)p.seed << 32) ^ ((uint64_t)round << 24) ^ (uint64_t)tile };
+                for (int d = 0; d < perTileRound; ++d) {
+                    float x = x0 + rng.Next() * (x1 - x0);
+                    float z = z0 + rng.Next() * (z1 - z0);
+                    runDroplet(h, dim, p, x, z, bounds);
+                }
+            });
+        }
+    }
+}
+
+// Each step moves a fraction of the height above the talus slope from every sample to each
+// lower neighbour. Steps read one buffer and write the other, so rows are independent.
+static void erodeThermal(std::vector<float>& h, int dim, float spacing, const TerrainErosion& p, ThreadPool& pool) {
+    const float talus = p.talusSlope * spacing;
+    const float talusDiag = talus * 1.41421356f;
+    // Eight neighbours; keeping each share under 1/8 cannot overshoot
+    const float k = std::clamp(p.thermalRate, 0.0f, 1.0f) * 0.125f;
+    std::vector<float> next(h.size());
+    for (int iter = 0; iter < p.thermalIterations; ++iter) {
+        pool.ParallelFor(0, dim, [&](int j) {
+            for (int i = 0; i < dim; ++i) {
+                float hc = h[(size_t)j * dim + i];
+                float change = 0.0f;
+                for (int dj = -1; dj <= 1; ++dj) {
+                    for (int di = -1; di <= 1; ++di) {
+                        int ni = i + di, nj = j + dj;
+                        if ((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= dim || nj >= dim) continue;
+                        float hn = h[(size_t)nj * dim + ni];
+                        float t = (di != 0 && dj != 0) ? talusDiag : talus;
+                        // Outflow to lower neighbours, inflow from higher ones
+                        change -= k * std::max(hc - hn - t, 0.0f);
+                        change += k * std::max(hn - hc - t, 0.0f);
+                    }
+                }
+                next[(size_t)j * dim + i] = hc + change;
+            }
+        });
+        h.swap(next);
+    }
+}
+
+void TerrainErosionMap::Clear() {
+    m_Offsets.clear();
+    m_Offsets.shrink_to_fit();
+    m_Dim = 0;
+}
+
+void TerrainErosionMap::Compute(const TerrainErosion& params, const std::vector<float>& heights, int dim,
+                                float origin, float spacing, ThreadPool& pool) {
+    Clear();
+    if (dim < 2) return;
+    std::vector<float> h = heights;
+    if (params.droplets > 0) erodeHydraulic(h, dim, params, pool);
+    if (params.thermalIterations > 0) erodeThermal(h, dim, spacing, params, pool);
+
+    // Fade the offsets out over the border samples so the eroded grid meets the uneroded
+    // surface around it without a step
+    const float fade = (float)std::max(2, dim / 16);
+    auto weight = [&](int i) {
+        float t = std::min(std::min(i, dim - 1 - i) / fade, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    };
+    m_Offsets.resize((size_t)dim * dim);
+    for (int j = 0; j < dim; ++j) {
+        for (int i = 0; i < dim; ++i) {
+            size_t k = (size_t)j * dim + i;
+            m_Offsets[k] = (h[k] - heights[k]) * weight(i) * weight(j);
+        }
+    }
+    m_Dim = dim;
+    m_Origin = origin;
+    m_Spacing = spacing;
+}
+
+bool TerrainErosionMap::Load(const std::string& path, uint64_t key, int dim, float origin, float spacing) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    ErosionFileHeader h;
+    bool ok = std::fread(&h, sizeof(h), 1, file) == 1 &&
+              std::memcmp(h.magic, EROSION_MAGIC, sizeof(EROSION_MAGIC)) == 0 &&
+              h.version == EROSION_VERSION && h.key == key && h.dim == dim &&
+              h.origin == origin && h.spacing == spacing;
+    std::vector<float> offsets;
+    if (ok) {
+        offsets.resize((size_t)dim * dim);
+        ok = std::fread(offsets.data(), sizeof(float), offsets.size(), file) == offsets.size();
+    }
+    std::fclose(file);
+    if (!ok) {
+        printf("Ignoring stale erosion cache: %s\n", path.c_str());
+        return false;
+    }
+    m_Offsets.swap(offsets);
+    m_Dim = dim;
+    m_Origin = origin;
+    m_Spacing = spacing;
+    return true;
+}
+
+bool TerrainErosionMap::Save(const std::string& path, uint64_t key) const {
+    // Written to a temporary name and renamed, so an interrupted run never leaves a
+    // truncated file under the real name
+    std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        printf("Failed to create erosion cache: %s\n", tmp.c_str());
+        return false;
+    }
+    ErosionFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, EROSION_MAGIC, sizeof(EROSION_MAGIC));
+    h.version = EROSION_VERSION;
+    h.dim = m_Dim;
+    h.key = key;
+    h.origin = m_Origin;
+    h.spacing = m_Spacing;
+    bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1 &&
+              std::fwrite(m_Offsets.data(), sizeof(float), m_Offsets.size(), file) == m_Offsets.size();
+    ok = (std::fclose(file) == 0) && ok;
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        printf("Failed to write erosion cache: %s\n", path.c_str());
+        std::remove(tmp.c_str());
+    }
+    return ok;
+}
+
+float TerrainErosionMap::HeightAt(float x, float z) const {
+    if (m_Offsets.empty()) return 0.0f;
+    float u = (x - m_Origin) / m_Spacing, v = (z - m_Origin) / m_Spacing;
+    if (!(u >= 0.0f && v >= 0.0f && u <= m_Dim - 1 && v <= m_Dim - 1)) return 0.0f;
+    int i0 = std::min((int)u, m_Dim - 2), j0 = std::min((int)v, m_Dim - 2);
+    float fx = u - i0, fz = v - j0;
+    const float* row0 = &m_Offsets[(size_t)j0 * m_Dim + i0];
+    const float* row1 = row0 + m_Dim;
+    float a = row0[0] + (row0[1] - row0[0]) * fx;
+    float b = row1[0] + (row1[1] - row1[0]) * fx;
+    return a + (b - a) * fz;
+}
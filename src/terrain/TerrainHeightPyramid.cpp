@@ -0,0 +1,181 @@
+#include "../../include/terrain/TerrainHeightPyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void TerrainHeightPyramid::Clear() {
+    m_Levels.clear();
+    m_Cells = 0;
+}
+
+void TerrainHeightPyramid::Build(const TerrainSharedGrid& heights, float origin, float spacing) {
+    Clear();
+    if (heights.Width() < 2) return;
+    m_Cells = heights.Width() - 1;
+    m_Origin = origin;
+    m_Spacing = spacing;
+
+    int size = m_Cells;
+    for (;;) {
+        Level level;
+        level.size = size;
+        level.minH.Reset(size, size);
+        level.maxH.Reset(size, size);
+        m_Levels.push_back(std::move(level));
+        if (size == 1) break;
+        size = (size + 1) / 2;
+    }
+    Update(heights, 0, 0, m_Cells, m_Cells);
+}
+
+void TerrainHeightPyramid::Update(const TerrainSharedGrid& heights, int i0, int j0, int i1, int j1) {
+    if (Empty()) return;
+    // Cells touching the changed samples
+    int ci0 = std::max(i0 - 1, 0), cj0 = std::max(j0 - 1, 0);
+    int ci1 = std::min(i1, m_Cells - 1), cj1 = std::min(j1, m_Cells - 1);
+    if (ci0 > ci1 || cj0 > cj1) return;
+    Level& base = m_Levels[0];
+    for (int j = cj0; j <= cj1; ++j) {
+        const float* row0 = heights.Row(j);
+        const float* row1 = heights.Row(j + 1);
+        float* lo = base.minH.MutableRow(j);
+        float* hi = base.maxH.MutableRow(j);
+        // A bilinear patch never leaves the range of its corners
+        for (int i = ci0; i <= ci1; ++i) {
+            lo[i] = std::min(std::min(row0[i], row0[i + 1]), std::min(row1[i], row1[i + 1]));
+            hi[i] = std::max(std::max(row0[i], row0[i + 1]), std::max(row1[i], row1[i + 1]));
+        }
+    }
+    for (int level = 1; level < (int)m_Levels.size(); ++level) {
+        ci0 >>= 1; cj0 >>= 1; ci1 >>= 1; cj1 >>= 1;
+        const Level& c = m_Levels[level - 1];
+        Level& l = m_Levels[level];
+        for (int nj = cj0; nj <= cj1; ++nj) {
+            float* lo = l.minH.MutableRow(nj);
+            float* hi = l.maxH.MutableRow(nj);
+            for (int ni = ci0; ni <= ci1; ++ni) {
+                float a = std::numeric_limits<float>::infinity(), b = -a;
+                for (int j = nj * 2; j < std::min(nj * 2 + 2, c.size); ++j) {
+                    const float* cLo = c.minH.Row(j);
+                    const float* cHi = c.maxH.Row(j);
+                    for (int i = ni * 2; i < std::min(ni * 2 + 2, c.size); ++i) {
+                        a = std::min(a, cLo[i]);
+                        b = std::max(b, cHi[i]);
+                    }
+                }
+                lo[ni] = a;
+                hi[ni] = b;
+            }
+        }
+    }
+}
+
+// Parameter range where the ray is inside the XZ box, clipped to [ta, tb]
+static bool clipToBox(const glm::vec3& o, const glm::vec3& d, float x0, float x1, float z0, float z1,
+                      float& ta, float& tb) {
+    auto slab = [&](float p, float v, float lo, float hi) {
+        if (std::fabs(v) < 1e-12f) return p >= lo && p <= hi;
+        float t0 = (lo - p) / v, t1 = (hi - p) / v;
+        if (t0 > t1) std::swap(t0, t1);
+        ta = std::max(ta, t0);
+        tb = std::min(tb, t1);
+        return ta <= tb;
+    };
+    return slab(o.x, d.x, x0, x1) && slab(o.z, d.z, z0, z1);
+}
+
+bool TerrainHeightPyramid::hitCell(const TerrainSharedGrid& heights, int ci, int cj, const glm::vec3& o,
+                                   const glm::vec3& d, float ta, float tb, float& tHit) const {
+    const float* row0 = heights.Row(cj) + ci;
+    const float* row1 = heights.Row(cj + 1) + ci;
+    float h00 = row0[0], h10 = row0[1], h01 = row1[0], h11 = row1[1];
+    float p = h10 - h00, q = h01 - h00, r = h00 - h10 - h01 + h11;
+
+    // Cell-local coordinates along the ray: u = a + b t, v = c + e t
+    float x0 = m_Origin + ci * m_Spacing, z0 = m_Origin + cj * m_Spacing;
+    float a = (o.x - x0) / m_Spacing, b = d.x / m_Spacing;
+    float c = (o.z - z0) / m_Spacing, e = d.z / m_Spacing;
+    // Ray height minus surface height: f(t) = qa t^2 + qb t + qc
+    float qa = -(r * b * e);
+    float qb = d.y - (p * b + q * e + r * (a * e + b * c));
+    float qc = o.y - (h00 + p * a + q * c + r * a * c);
+    auto f = [&](float t) { return (qa * t + qb) * t + qc; };
+
+    if (f(ta) <= 0.0f) { tHit = ta; return true; }
+    float roots[2];
+    int n = 0;
+    if (std::fabs(qa) < 1e-9f) {
+        if (std::fabs(qb) < 1e-12f) return false;
+        roots[n++] = -qc / qb;
+    } else {
+        float disc = qb * qb - 4.0f * qa * qc;
+        if (disc < 0.0f) return false;
+        // Numerically stable pair
+        float s = -0.5f * (qb + std::copysign(std::sqrt(disc), qb));
+        roots[n++] = s / qa;
+        if (s != 0.0f) roots[n++] = qc / s;
+        if (n == 2 && roots[1] < roots[0]) std::swap(roots[0], roots[1]);
+    }
+    const float eps = 1e-4f * (tb - ta) + 1e-6f;
+    for (int k = 0; k < n; ++k) {
+        if (roots[k] >= ta - eps && roots[k] <= tb + eps) {
+            tHit = std::clamp(roots[k], ta, tb);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TerrainHeightPyramid::Raycast(const TerrainSharedGrid& heights, const glm::vec3& o, const glm::vec3& d,
+                                   float tMin, float tMax, float& tHit) const {
+    if (Empty() || !(tMin <= tMax)) return false;
+    struct Node { int level, i, j; float ta, tb; };
+    // Depth-first, nearest child on top; each level pushes at most four nodes
+    Node stack[4 * 32];
+    int top = 0;
+
+    auto nodeBox = [&](int level, int i, int j, float& x0, float& x1, float& z0, float& z1) {
+        int span = 1 << level;
+        x0 = m_Origin + (i * span) * m_Spacing;
+        z0 = m_Origin + (j * span) * m_Spacing;
+        x1 = m_Origin + std::min((i + 1) * span, m_Cells) * m_Spacing;
+        z1 = m_Origin + std::min((j + 1) * span, m_Cells) * m_Spacing;
+    };
+
+    int rootLevel = (int)m_Levels.size() - 1;
+    float x0, x1, z0, z1, ta = tMin, tb = tMax;
+    nodeBox(rootLevel, 0, 0, x0, x1, z0, z1);
+    if (!clipToBox(o, d, x0, x1, z0, z1, ta, tb)) return false;
+    stack[top++] = Node{ rootLevel, 0, 0, ta, tb };
+
+    while (top > 0) {
+        Node n = stack[--top];
+        const Level& l = m_Levels[n.level];
+        float yMin = std::min(o.y + d.y * n.ta, o.y + d.y * n.tb);
+        if (yMin > l.maxH.Row(n.j)[n.i]) continue; // passes above everything here
+        if (n.level == 0) {
+            if (hitCell(heights, n.i, n.j, o, d, n.ta, n.tb, tHit)) return true;
+            continue;
+        }
+        const Level& c = m_Levels[n.level - 1];
+        Node children[4];
+        int count = 0;
+        for (int j = n.j * 2; j < std::min(n.j * 2 + 2, c.size); ++j) {
+            for (int i = n.i * 2; i < std::min(n.i * 2 + 2, c.size); ++i) {
+                float cta = n.ta, ctb = n.tb;
+                nodeBox(n.level - 1, i, j, x0, x1, z0, z1);
+                if (clipToBox(o, d, x0, x1, z0, z1, cta, ctb)) children[count++] = Node{ n.level - 1, i, j, cta, ctb };
+            }
+        }
+        // Push farthest first so the child the ray enters first is visited next (insertion
+        // sort: there are at most four)
+        for (int k = 1; k < count; ++k) {
+            Node c = children[k];
+            int m = k;
+            for (; m > 0 && children[m - 1].ta < c.ta; --m) children[m] = children[m - 1];
+            children[m] = c;
+        }
+        for (int k = 0; k < count; ++k) stack[top++] = children[k];
+    }
+    return false;
+}
@@ -0,0 +1,174 @@
+#include "../../include/terrain/TerrainHeightmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char HEIGHTMAP_MAGIC[8] = { 'T', 'E', 'R', 'R', 'H', 'M', 'A', 'P' };
+static const uint32_t HEIGHTMAP_VERSION = 1;
+
+TerrainHeightmap::~TerrainHeightmap() {
+    Close();
+}
+
+void TerrainHeightmap::Close() {
+    if (m_Data) munmap((void*)m_Data, m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Header = nullptr;
+    m_TileOffsets = nullptr;
+}
+
+bool TerrainHeightmap::Open(const std::string& path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open heightmap: %s\n", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TerrainHeightmapHeader)) {
+        printf("Heightmap too small: %s\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (data == MAP_FAILED) {
+        printf("Failed to map heightmap: %s\n", path.c_str());
+        return false;
+    }
+    // Samples are read scattered by tile, so read-ahead would mostly fetch unused pages
+    madvise(data, size, MADV_RANDOM);
+
+    m_Data = (const unsigned char*)data;
+    m_Size = size;
+    m_Header = (const TerrainHeightmapHeader*)m_Data;
+    m_TileOffsets = (const uint64_t*)(m_Data + sizeof(TerrainHeightmapHeader));
+
+    const TerrainHeightmapHeader& h = *m_Header;
+    const char* problem = nullptr;
+    uint64_t tileCount = (uint64_t)h.tilesX * h.tilesZ;
+    uint64_t tileBytes = (uint64_t)h.tileSize * h.tileSize * sizeof(uint16_t);
+    if (std::memcmp(h.magic, HEIGHTMAP_MAGIC, sizeof(HEIGHTMAP_MAGIC)) != 0) problem = "bad magic";
+    else if (h.version != HEIGHTMAP_VERSION) problem = "unsupported version";
+    else if (h.tileSize == 0 || h.width == 0 || h.height == 0 || !(h.spacing > 0.0f)) problem = "empty grid";
+    // Bounded before the checks below compute sizes and offsets from these fields
+    else if (h.width > HEIGHTMAP_MAX_SIDE || h.height > HEIGHTMAP_MAX_SIDE) problem = "grid too large";
+    else if (h.tileSize > HEIGHTMAP_MAX_TILE_SIZE) problem = "tiles too large";
+    else if (h.tilesX != (h.width + h.tileSize - 1) / h.tileSize ||
+             h.tilesZ != (h.height + h.tileSize - 1) / h.tileSize) problem = "tile count mismatch";
+    else if (sizeof(TerrainHeightmapHeader) + tileCount * sizeof(uint64_t) > size) problem = "truncated tile index";
+    if (!problem) {
+        // Only the index is touched here; tile pages stay on disk until sampled
+        for (uint64_t t = 0; t < tileCount; ++t) {
+            uint64_t off = m_TileOffsets[t];
+            if (off && (off % sizeof(uint16_t) != 0 || off > size || size - off < tileBytes)) {
+                problem = "tile outside the file";
+                break;
+            }
+        }
+    }
+    if (problem) {
+        printf("Invalid heightmap %s: %s\n", path.c_str(), problem);
+        Close();
+        return false;
+    }
+    printf("Mapped heightmap %s (%ux%u samples, %u tiles)\n", path.c_str(), h.width, h.height,
+           h.tilesX * h.tilesZ);
+    return true;
+}
+
+float TerrainHeightmap::Sample(int i, int j) const {
+    const TerrainHeightmapHeader& h = *m_Header;
+    i = std::clamp(i, 0, (int)h.width - 1);
+    j = std::clamp(j, 0, (int)h.height - 1);
+    const int ts = (int)h.tileSize;
+    uint64_t off = m_TileOffsets[(size_t)(j / ts) * h.tilesX + (size_t)(i / ts)];
+    if (!off) return h.heightMin;
+    const uint16_t* tile = (const uint16_t*)(m_Data + off);
+    return h.heightMin + tile[(j % ts) * ts + (i % ts)] * h.heightScale;
+}
+
+float TerrainHeightmap::HeightAt(float x, float z) const {
+    const TerrainHeightmapHeader& h = *m_Header;
+    float u = std::clamp((x - h.originX) / h.spacing, 0.0f, (float)(h.width - 1));
+    float v = std::clamp((z - h.originZ) / h.spacing, 0.0f, (float)(h.height - 1));
+    int i0 = std::min((int)u, std::max((int)h.width - 2, 0));
+    int j0 = std::min((int)v, std::max((int)h.height - 2, 0));
+    float fx = u - i0, fz = v - j0;
+    float h00 = Sample(i0, j0), h10 = Sample(i0 + 1, j0);
+    float h01 = Sample(i0, j0 + 1), h11 = Sample(i0 + 1, j0 + 1);
+    float a = h00 + (h10 - h00) * fx;
+    float b = h01 + (h11 - h01) * fx;
+    return a + (b - a) * fz;
+}
+
+bool TerrainHeightmap::Write(const std::string& path, const float* heights, int width, int height,
+                             float originX, float originZ, float spacing, int tileSize) {
+    if (width <= 0 || height <= 0 || tileSize <= 0 || !(spacing > 0.0f)) return false;
+    // Open would refuse the file
+    if ((uint32_t)width > HEIGHTMAP_MAX_SIDE || (uint32_t)height > HEIGHTMAP_MAX_SIDE ||
+        (uint32_t)tileSize > HEIGHTMAP_MAX_TILE_SIZE) return false;
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        printf("Failed to create heightmap: %s\n", path.c_str());
+        return false;
+    }
+
+    size_t count = (size_t)width * height;
+    float lo = *std::min_element(heights, heights + count);
+    float hi = *std::max_element(heights, heights + count);
+
+    TerrainHeightmapHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, HEIGHTMAP_MAGIC, sizeof(HEIGHTMAP_MAGIC));
+    h.version = HEIGHTMAP_VERSION;
+    h.tileSize = (uint32_t)tileSize;
+    h.width = (uint32_t)width;
+    h.height = (uint32_t)height;
+    h.tilesX = (uint32_t)((width + tileSize - 1) / tileSize);
+    h.tilesZ = (uint32_t)((height + tileSize - 1) / tileSize);
+    h.originX = originX;
+    h.originZ = originZ;
+    h.spacing = spacing;
+    h.heightMin = lo;
+    h.heightScale = (hi - lo) / 65535.0f;
+
+    // Tiles follow the index back to back, starting on a page boundary
+    size_t tileCount = (size_t)h.tilesX * h.tilesZ;
+    size_t tileBytes = (size_t)tileSize * tileSize * sizeof(uint16_t);
+    uint64_t first = sizeof(h) + tileCount * sizeof(uint64_t);
+    first = (first + 4095) & ~(uint64_t)4095;
+    std::vector<uint64_t> offsets(tileCount);
+    for (size_t t = 0; t < tileCount; ++t) offsets[t] = first + t * tileBytes;
+
+    bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1;
+    ok = ok && std::fwrite(offsets.data(), sizeof(uint64_t), tileCount, file) == tileCount;
+    std::vector<char> pad((size_t)(first - sizeof(h) - tileCount * sizeof(uint64_t)), 0);
+    ok = ok && (pad.empty() || std::fwrite(pad.data(), 1, pad.size(), file) == pad.size());
+
+    std::vector<uint16_t> tile((size_t)tileSize * tileSize);
+    for (uint32_t tz = 0; ok && tz < h.tilesZ; ++tz) {
+        for (uint32_t tx = 0; ok && tx < h.tilesX; ++tx) {
+            for (int j = 0; j < tileSize; ++j) {
+                int gj = std::min((int)tz * tileSize + j, height - 1);
+                for (int i = 0; i < tileSize; ++i) {
+                    int gi = std::min((int)tx * tileSize + i, width - 1);
+                    float q = h.heightScale > 0.0f ? (heights[(size_t)gj * width + gi] - lo) / h.heightScale : 0.0f;
+                    tile[(size_t)j * tileSize + i] = (uint16_t)std::clamp(std::lround(q), 0L, 65535L);
+                }
+            }
+            ok = std::fwrite(tile.data(), sizeof(uint16_t), tile.size(), file) == tile.size();
+        }
+    }
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) printf("Failed to write heightmap: %s\n", path.c_str());
+    return ok;
+}
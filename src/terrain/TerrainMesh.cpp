@@ -0,0 +1,205 @@
+#include "../../include/terrain/TerrainMesh.h"
+#include <cstdio>
+
+// Compact chunks are drawn by a vertex-only program; the fragment stage stays fixed
+// function. Lighting (light 0, with GL_COLOR_MATERIAL-style ambient and diffuse) and fog
+// coordinates follow the fixed pipeline so both formats look the same.
+static const char* COMPACT_VERTEX_SHADER = R"(#version 130
+in float aHeight;
+in vec2 aNormal;
+in vec3 aColor;
+uniform vec2 uOrigin;
+uniform float uStep;
+uniform int uDim;
+uniform vec3 uHeight; // offset, scale, skirt depth
+uniform bool uLighting;
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    int grid = uDim * uDim;
+    int i, j;
+    float y = uHeight.x + aHeight * uHeight.y;
+    if (gl_VertexID < grid) {
+        i = gl_VertexID % uDim;
+        j = gl_VertexID / uDim;
+    } else {
+        // Skirts: z = min, z = max, x = min, x = max edge, uDim vertices each
+        int s = gl_VertexID - grid;
+        int edge = s / uDim, k = s % uDim, last = uDim - 1;
+        i = edge < 2 ? k : (edge == 2 ? 0 : last);
+        j = edge < 2 ? (edge == 0 ? 0 : last) : k;
+        y -= uHeight.z;
+    }
+    vec4 eye = gl_ModelViewMatrix * vec4(uOrigin.x + float(i) * uStep, y, uOrigin.y + float(j) * uStep, 1.0);
+    gl_Position = gl_ProjectionMatrix * eye;
+    gl_FogFragCoord = abs(eye.z);
+
+    vec4 color = vec4(aColor, 1.0);
+    if (uLighting) {
+        vec3 n = normalize(gl_NormalMatrix * decodeNormal(aNormal));
+        vec4 lp = gl_LightSource[0].position;
+        vec3 l = normalize(lp.xyz - eye.xyz * lp.w);
+        vec4 lit = gl_LightModel.ambient + gl_LightSource[0].ambient +
+                   gl_LightSource[0].diffuse * max(dot(n, l), 0.0);
+        color = vec4(clamp(lit.rgb * aColor, 0.0, 1.0), 1.0);
+    }
+    gl_FrontColor = color;
+    gl_BackColor = color;
+}
+)";
+
+enum { ATTR_HEIGHT = 0, ATTR_NORMAL = 1, ATTR_COLOR = 2 };
+
+struct CompactProgram {
+    bool tried = false;
+    GLuint program = 0;
+    GLint origin = -1, step = -1, dim = -1, height = -1, lighting = -1;
+};
+static CompactProgram s_compact;
+
+static bool buildCompactProgram(CompactProgram& p) {
+    if (!GLEW_VERSION_3_0) return false;
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &COMPACT_VERTEX_SHADER, nullptr);
+    glCompileShader(vs);
+    GLint ok = GL_FALSE;
+    char log[1024];
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        glGetShaderInfoLog(vs, sizeof(log), nullptr, log);
+        printf("Compact terrain shader failed to compile, using float vertices:\n%s\n", log);
+        glDeleteShader(vs);
+        return false;
+    }
+    p.program = glCreateProgram();
+    glAttachShader(p.program, vs);
+    glBindAttribLocation(p.program, ATTR_HEIGHT, "aHeight");
+    glBindAttribLocation(p.program, ATTR_NORMAL, "aNormal");
+    glBindAttribLocation(p.program, ATTR_COLOR, "aColor");
+    glLinkProgram(p.program);
+    glDeleteShader(vs); // freed with the program
+    glGetProgramiv(p.program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        glGetProgramInfoLog(p.program, sizeof(log), nullptr, log);
+        printf("Compact terrain shader failed to link, using float vertices:\n%s\n", log);
+        glDeleteProgram(p.program);
+        p.program = 0;
+        return false;
+    }
+    p.origin = glGetUniformLocation(p.program, "uOrigin");
+    p.step = glGetUniformLocation(p.program, "uStep");
+    p.dim = glGetUniformLocation(p.program, "uDim");
+    p.height = glGetUniformLocation(p.program, "uHeight");
+    p.lighting = glGetUniformLocation(p.program, "uLighting");
+    return true;
+}
+
+bool TerrainMesh::CompactSupported() {
+    if (!s_compact.tried) {
+        s_compact.tried = true;
+        buildCompactProgram(s_compact);
+    }
+    return s_compact.program != 0;
+}
+
+void TerrainIndexBuffer::Upload(const std::vector<GLuint>& indices) {
+    if (!m_IBO) glGenBuffers(1, &m_IBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                 indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    m_Count = (GLsizei)indices.size();
+}
+
+void TerrainIndexBuffer::Release() {
+    if (m_IBO) glDeleteBuffers(1, &m_IBO);
+    m_IBO = 0;
+    m_Count = 0;
+}
+
+void TerrainMesh::Upload(const std::vector<TerrainVertex>& vertices) {
+    if (!m_VBO) glGenBuffers(1, &m_VBO);
+    m_Bytes = vertices.size() * sizeof(TerrainVertex);
+    m_Compact = false;
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, m_Bytes, vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TerrainMesh::UploadCompact(const std::vector<TerrainCompactVertex>& vertices,
+                                const TerrainCompactPlacement& placement) {
+    if (!m_VBO) glGenBuffers(1, &m_VBO);
+    m_Bytes = vertices.size() * sizeof(TerrainCompactVertex);
+    m_Compact = true;
+    m_Placement = placement;
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, m_Bytes, vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TerrainMesh::BeginDraw(const TerrainIndexBuffer& indices, bool compact) {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.Handle());
+    if (compact) {
+        glUseProgram(s_compact.program);
+        glUniform1i(s_compact.lighting, glIsEnabled(GL_LIGHTING) ? 1 : 0);
+        glEnableVertexAttribArray(ATTR_HEIGHT);
+        glEnableVertexAttribArray(ATTR_NORMAL);
+        glEnableVertexAttribArray(ATTR_COLOR);
+        return;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+}
+
+void TerrainMesh::Draw(const TerrainIndexBuffer& indices) const {
+    if (!m_VBO || !indices.Count()) return;
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    if (m_Compact) {
+        const TerrainCompactPlacement& p = m_Placement;
+        glUniform2f(s_compact.origin, p.originX, p.originZ);
+        glUniform1f(s_compact.step, p.step);
+        glUniform1i(s_compact.dim, p.dim);
+        glUniform3f(s_compact.height, p.heightOffset, p.heightScale, p.skirtDepth);
+        const GLsizei stride = sizeof(TerrainCompactVertex);
+        glVertexAttribPointer(ATTR_HEIGHT, 1, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                              (const void*)offsetof(TerrainCompactVertex, height));
+        glVertexAttribPointer(ATTR_NORMAL, 2, GL_BYTE, GL_TRUE, stride,
+                              (const void*)offsetof(TerrainCompactVertex, normal));
+        glVertexAttribPointer(ATTR_COLOR, 3, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              (const void*)offsetof(TerrainCompactVertex, color));
+        glDrawElements(GL_TRIANGLES, indices.Count(), GL_UNSIGNED_INT, nullptr);
+        return;
+    }
+    glVertexPointer(3, GL_FLOAT, sizeof(TerrainVertex), (const void*)offsetof(TerrainVertex, x));
+    glNormalPointer(GL_FLOAT, sizeof(TerrainVertex), (const void*)offsetof(TerrainVertex, nx));
+    glColorPointer(3, GL_FLOAT, sizeof(TerrainVertex), (const void*)offsetof(TerrainVertex, r));
+    glDrawElements(GL_TRIANGLES, indices.Count(), GL_UNSIGNED_INT, nullptr);
+}
+
+void TerrainMesh::EndDraw(bool compact) {
+    if (compact) {
+        glDisableVertexAttribArray(ATTR_COLOR);
+        glDisableVertexAttribArray(ATTR_NORMAL);
+        glDisableVertexAttribArray(ATTR_HEIGHT);
+        glUseProgram(0);
+    } else {
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TerrainMesh::Release() {
+    if (m_VBO) glDeleteBuffers(1, &m_VBO);
+    m_VBO = 0;
+    m_Bytes = 0;
+    m_Compact = false;
+}
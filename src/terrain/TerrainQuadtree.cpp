@@ -0,0 +1,400 @@
+#include "../../include/terrain/TerrainQuadtree.h"
+#include "../../include/core/ThreadPool.h"
+#include "../../include/core/Rcu.h"
+#include <algorithm>
+#include <cmath>
+
+// Quad index (from the world origin) of a node's minimum corner
+static void nodeOriginQuads(const TerrainLayout& layout, const TerrainChunkKey& key, int& qx, int& qz) {
+    int worldQuads = layout.chunkQuads << layout.levels;
+    int nodeQuads = layout.chunkQuads << key.level;
+    qx = -worldQuads / 2 + key.x * nodeQuads;
+    qz = -worldQuads / 2 + key.z * nodeQuads;
+}
+
+void buildTerrainChunk(const TerrainLayout& layout, const TerrainChunkKey& key, TerrainChunkData& out) {
+    const int Q = layout.chunkQuads;
+    const int DIM = Q + 1;
+    const int step = 1 << key.level;
+    int qx, qz;
+    nodeOriginQuads(layout, key, qx, qz);
+
+    out.vertices.clear();
+    out.vertices.reserve((size_t)DIM * DIM + 4 * DIM);
+    out.minY = 1e30f;
+    out.maxY = -1e30f;
+
+    // Heights with a one-sample apron so normals at the chunk edge use the same central
+    // differences as the interior (and match the neighbouring chunk at this level)
+    const int APRON = DIM + 2;
+    std::vector<float> xs(APRON), zs(APRON), hs((size_t)APRON * APRON);
+    for (int i = 0; i < APRON; ++i) xs[i] = (qx + (i - 1) * step) * layout.spacing;
+    for (int j = 0; j < APRON; ++j) {
+        std::fill(zs.begin(), zs.end(), (qz + (j - 1) * step) * layout.spacing);
+        getTerrainHeightBatch(xs.data(), zs.data(), &hs[(size_t)j * APRON], APRON);
+    }
+
+    const float inv2d = 1.0f / (2.0f * step * layout.spacing);
+    for (int j = 0; j < DIM; ++j) {
+        const float* row = &hs[(size_t)(j + 1) * APRON + 1];
+        float z = (qz + j * step) * layout.spacing;
+        for (int i = 0; i < DIM; ++i) {
+            float x = xs[i + 1];
+            float y = row[i];
+            glm::vec3 n = glm::normalize(glm::vec3((row[i - 1] - row[i + 1]) * inv2d, 1.0f,
+                                                   (row[i - APRON] - row[i + APRON]) * inv2d));
+            glm::vec3 c = terrainColor(y, getMountainContribution(x, z));
+            out.vertices.push_back(TerrainVertex{ x, y, z, n.x, n.y, n.z, c.r, c.g, c.b });
+            out.minY = std::min(out.minY, y);
+            out.maxY = std::max(out.maxY, y);
+        }
+    }
+
+    // Skirts: a lowered copy of each edge. Deep enough to cover the largest possible step
+    // between this chunk's edge and a finer or coarser neighbour.
+    float skirtDepth = (out.maxY - out.minY) + step * layout.spacing;
+    out.skirtDepth = skirtDepth;
+    auto addSkirt = [&](int i0, int j0, int di, int dj) {
+        for (int k = 0; k < DIM; ++k) {
+            TerrainVertex v = out.vertices[(size_t)(j0 + dj * k) * DIM + (i0 + di * k)];
+            v.y -= skirtDepth;
+            out.vertices.push_back(v);
+        }
+    };
+    addSkirt(0, 0, 1, 0); // z = min edge
+    addSkirt(0, Q, 1, 0); // z = max edge
+    addSkirt(0, 0, 0, 1); // x = min edge
+    addSkirt(Q, 0, 0, 1); // x = max edge
+}
+
+static uint8_t unitToByte(float v) {
+    return (uint8_t)std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+}
+
+// Octahedral map around +Y (terrain normals point mostly up, so they land in the inner,
+// finest part of the square), stored as two signed normalized bytes
+static void encodeNormal(float nx, float ny, float nz, int8_t out[2]) {
+    float l1 = std::fabs(nx) + std::fabs(ny) + std::fabs(nz);
+    float u = nx / l1, v = nz / l1;
+    if (ny < 0.0f) {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+    out[0] = (int8_t)std::lround(std::clamp(u, -1.0f, 1.0f) * 127.0f);
+    out[1] = (int8_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f);
+}
+
+void packTerrainChunk(const TerrainLayout& layout, const TerrainChunkKey& key, TerrainChunkData& data) {
+    const int DIM = layout.chunkQuads + 1;
+    const size_t grid = (size_t)DIM * DIM;
+    int qx, qz;
+    nodeOriginQuads(layout, key, qx, qz);
+    TerrainCompactPlacement& p = data.placement;
+    p.originX = qx * layout.spacing;
+    p.originZ = qz * layout.spacing;
+    p.step = (1 << key.level) * layout.spacing;
+    p.heightOffset = data.minY;
+    p.heightScale = data.maxY - data.minY;
+    p.skirtDepth = data.skirtDepth;
+    p.dim = DIM;
+
+    // Skirt vertices store their edge vertex's height; the shader lowers them, so the
+    // 16 bits only have to span the chunk's own height range
+    const float toUnit = p.heightScale > 0.0f ? 65535.0f / p.heightScale : 0.0f;
+    data.compact.resize(data.vertices.size());
+    for (size_t k = 0; k < data.vertices.size(); ++k) {
+        const TerrainVertex& v = data.vertices[k];
+        TerrainCompactVertex& c = data.compact[k];
+        float y = k < grid ? v.y : v.y + data.skirtDepth;
+        c.height = (uint16_t)std::lround(std::clamp((y - p.heightOffset) * toUnit, 0.0f, 65535.0f));
+        encodeNormal(v.nx, v.ny, v.nz, c.normal);
+        c.color[0] = unitToByte(v.r);
+        c.color[1] = unitToByte(v.g);
+        c.color[2] = unitToByte(v.b);
+        c.pad = 0;
+    }
+    data.vertices.clear();
+    data.vertices.shrink_to_fit();
+}
+
+std::vector<GLuint> buildTerrainChunkIndices(int chunkQuads) {
+    const int Q = chunkQuads;
+    const GLuint DIM = (GLuint)(Q + 1);
+    std::vector<GLuint> indices;
+    indices.reserve((size_t)Q * Q * 6 + (size_t)4 * Q * 6);
+    for (int j = 0; j < Q; ++j) {
+        for (int i = 0; i < Q; ++i) {
+            GLuint i00 = (GLuint)j * DIM + (GLuint)i;
+            GLuint i10 = i00 + 1;
+            GLuint i01 = i00 + DIM;
+            GLuint i11 = i01 + 1;
+            indices.insert(indices.end(), { i00, i10, i11, i00, i11, i01 });
+        }
+    }
+    // Skirt strips: edge vertex k/k+1 joined to its lowered copy
+    const GLuint skirtBase = DIM * DIM;
+    auto edgeIndex = [&](int edge, int k) -> GLuint {
+        switch (edge) {
+            case 0: return (GLuint)k;
+            case 1: return (DIM - 1) * DIM + (GLuint)k;
+            case 2: return (GLuint)k * DIM;
+            default: return (GLuint)k * DIM + DIM - 1;
+        }
+    };
+    for (int edge = 0; edge < 4; ++edge) {
+        GLuint s = skirtBase + (GLuint)edge * DIM;
+        for (int k = 0; k < Q; ++k) {
+            GLuint t0 = edgeIndex(edge, k), t1 = edgeIndex(edge, k + 1);
+            GLuint b0 = s + (GLuint)k, b1 = b0 + 1;
+            indices.insert(indices.end(), { t0, t1, b1, t0, b1, b0 });
+        }
+    }
+    return indices;
+}
+
+static bool sameLayout(const TerrainLayout& a, const TerrainLayout& b) {
+    return a.chunkQuads == b.chunkQuads && a.levels == b.levels && a.spacing == b.spacing;
+}
+
+void TerrainQuadtree::Draw(const glm::vec3& eye, const glm::vec3& focus, const Frustum* frustum) {
+    const TerrainLayout& layout = terrainGetLayout();
+    bool compact = m_WantCompact && TerrainMesh::CompactSupported();
+    if (!m_HasLayout || !sameLayout(layout, m_Layout) || compact != m_Compact) {
+        Clear();
+        m_Layout = layout;
+        m_HasLayout = true;
+        m_Compact = compact;
+    }
+    if (!m_Indices.Count()) m_Indices.Upload(buildTerrainChunkIndices(m_Layout.chunkQuads));
+
+    ++m_Frame;
+    m_DrawList.clear();
+    m_Requests.clear();
+    m_CulledChunks = 0;
+
+    // Workers read the published snapshot, so builds submitted below see this frame's edits
+    terrainUpdateHeightCache();
+    uploadFinished();
+
+    // Tile under the focus; tile (0, 0) is the central one, centred on the origin
+    const int tileQuads = m_Layout.chunkQuads << m_Layout.levels;
+    const float tileSize = tileQuads * m_Layout.spacing;
+    const float origin = -(tileQuads / 2) * m_Layout.spacing;
+    int ftx = (int)std::floor((focus.x - origin) / tileSize);
+    int ftz = (int)std::floor((focus.z - origin) / tileSize);
+    m_RingTiles = 0;
+    m_ResidentTiles = 0;
+    for (int dz = -m_RingRadius; dz <= m_RingRadius; ++dz)
+        for (int dx = -m_RingRadius; dx <= m_RingRadius; ++dx)
+            selectTile(ftx + dx, ftz + dz, eye, frustum);
+
+    // Queue what this frame asked for: coarse levels first, then nearest first
+    std::sort(m_Requests.begin(), m_Requests.end(), [&](const TerrainChunkKey& a, const TerrainChunkKey& b) {
+        if (a.level != b.level) return a.level > b.level;
+        return distanceToNode(a, nullptr, eye) < distanceToNode(b, nullptr, eye);
+    });
+    for (const auto& key : m_Requests) {
+        if ((int)m_InFlight.size() >= m_MaxBuildsInFlight) break;
+        if (m_InFlight.count(key)) continue;
+        submitBuild(key);
+    }
+
+    glShadeModel(GL_SMOOTH);
+    TerrainMesh::BeginDraw(m_Indices, m_Compact);
+    for (const Chunk* c : m_DrawList) c->mesh.Draw(m_Indices);
+    TerrainMesh::EndDraw(m_Compact);
+
+    evictOverBudget();
+}
+
+void TerrainQuadtree::selectTile(int tx, int tz, const glm::vec3& eye, const Frustum* frustum) {
+    TerrainChunkKey root{ m_Layout.levels, tx, tz };
+    ++m_RingTiles;
+    if (m_Chunks.count(root)) ++m_ResidentTiles;
+    selectNode(root, eye, frustum);
+}
+
+void TerrainQuadtree::selectNode(const TerrainChunkKey& key, const glm::vec3& eye, const Frustum* frustum) {
+    auto it = m_Chunks.find(key);
+    if (it == m_Chunks.end()) {
+        // Only a tile root can be missing here (children are entered once all four are
+        // resident); the tile stays empty until its first build lands
+        m_Requests.push_back(key);
+        return;
+    }
+    Chunk* chunk = &it->second;
+    chunk->lastUsedFrame = m_Frame;
+    if (chunk->revision != terrainRevision()) {
+        // Edits elsewhere leave the chunk valid; only rebuild when one overlapped it
+        if (chunkEdited(key, chunk->revision)) m_Requests.push_back(key);
+        else chunk->revision = terrainRevision();
+    }
+    // Off-screen nodes stay resident (marked used above) so turning the camera back does
+    // not have to rebuild them, but nothing below them is drawn or requested
+    if (frustum && !nodeVisible(key, chunk, *frustum)) {
+        ++m_CulledChunks;
+        return;
+    }
+
+    if (key.level > 0 && shouldSplit(key, chunk, eye)) {
+        TerrainChunkKey children[4] = {
+            { key.level - 1, key.x * 2,     key.z * 2     },
+            { key.level - 1, key.x * 2 + 1, key.z * 2     },
+            { key.level - 1, key.x * 2,     key.z * 2 + 1 },
+            { key.level - 1, key.x * 2 + 1, key.z * 2 + 1 },
+        };
+        bool allResident = true;
+        for (const auto& c : children) {
+            if (m_Chunks.find(c) == m_Chunks.end()) {
+                allResident = false;
+                m_Requests.push_back(c);
+            }
+        }
+        if (allResident) {
+            for (const auto& c : children) selectNode(c, eye, frustum);
+            return;
+        }
+    }
+    m_DrawList.push_back(chunk);
+}
+
+bool TerrainQuadtree::nodeVisible(const TerrainChunkKey& key, const Chunk* chunk, const Frustum& frustum) const {
+    int qx, qz;
+    nodeOriginQuads(m_Layout, key, qx, qz);
+    float size = (m_Layout.chunkQuads << key.level) * m_Layout.spacing;
+    // The node's height range comes from its own samples; finer descendants can poke out
+    // between them, so pad it by one sample spacing
+    float pad = (1 << key.level) * m_Layout.spacing;
+    glm::vec3 lo(qx * m_Layout.spacing, chunk->minY - pad, qz * m_Layout.spacing);
+    return frustum.IntersectsBox(lo, glm::vec3(lo.x + size, chunk->maxY + pad, lo.z + size));
+}
+
+bool TerrainQuadtree::chunkEdited(const TerrainChunkKey& key, unsigned revision) const {
+    int qx, qz;
+    nodeOriginQuads(m_Layout, key, qx, qz);
+    // Grown by one sample: normals at the edge read the neighbouring heights
+    float sample = (1 << key.level) * m_Layout.spacing;
+    float size = (m_Layout.chunkQuads << key.level) * m_Layout.spacing;
+    float minX = qx * m_Layout.spacing - sample, minZ = qz * m_Layout.spacing - sample;
+    return terrainRegionChangedSince(revision, minX, minZ, minX + size + 2.0f * sample, minZ + size + 2.0f * sample);
+}
+
+float TerrainQuadtree::distanceToNode(const TerrainChunkKey& key, const Chunk* chunk, const glm::vec3& eye) const {
+    int qx, qz;
+    nodeOriginQuads(m_Layout, key, qx, qz);
+    float size = (m_Layout.chunkQuads << key.level) * m_Layout.spacing;
+    float minX = qx * m_Layout.spacing, minZ = qz * m_Layout.spacing;
+    float dx = std::max(std::max(minX - eye.x, 0.0f), eye.x - (minX + size));
+    float dz = std::max(std::max(minZ - eye.z, 0.0f), eye.z - (minZ + size));
+    float dy = 0.0f;
+    if (chunk) dy = std::max(std::max(chunk->minY - eye.y, 0.0f), eye.y - chunk->maxY);
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+bool TerrainQuadtree::shouldSplit(const TerrainChunkKey& key, const Chunk* chunk, const glm::vec3& eye) const {
+    float size = (m_Layout.chunkQuads << key.level) * m_Layout.spacing;
+    return distanceToNode(key, chunk, eye) < size * m_LodDistanceFactor;
+}
+
+void TerrainQuadtree::submitBuild(const TerrainChunkKey& key) {
+    m_InFlight.insert(key);
+    std::shared_ptr<BuildQueue> queue = m_Queue;
+    TerrainLayout layout = m_Layout;
+    bool compact = m_Compact;
+    ThreadPool::Shared().Submit([queue, layout, key, compact] {
+        BuildResult result{ key, 0, TerrainChunkData() };
+        {
+            // One snapshot for the whole build, so the chunk matches a single revision and the
+            // queries inside only bump a counter
+            TerrainReadScope scope;
+            result.revision = scope.Revision();
+            buildTerrainChunk(layout, key, result.data);
+        }
+        if (compact) packTerrainChunk(layout, key, result.data);
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->done.push_back(std::move(result));
+    });
+}
+
+void TerrainQuadtree::uploadFinished() {
+    std::vector<BuildResult> done;
+    {
+        std::lock_guard<std::mutex> lock(m_Queue->mutex);
+        done.swap(m_Queue->done);
+    }
+    // Builds run against the snapshot they started on, so edits never wait for them. A
+    // result older than the resident chunk is dropped. One built before an edit is still
+    // uploaded over an older chunk (better than nothing); it keeps its revision, so the
+    // next selection pass queues it again if the edit overlapped it.
+    for (const auto& r : done) {
+        m_InFlight.erase(r.key);
+        auto it = m_Chunks.find(r.key);
+        if (it != m_Chunks.end() && it->second.revision >= r.revision) continue;
+        storeChunk(r.key, r.revision, r.data);
+    }
+}
+
+void TerrainQuadtree::storeChunk(const TerrainChunkKey& key, unsigned revision, const TerrainChunkData& data) {
+    Chunk& chunk = m_Chunks[key];
+    m_ResidentBytes -= chunk.mesh.GpuBytes();
+    if (m_Compact) chunk.mesh.UploadCompact(data.compact, data.placement);
+    else chunk.mesh.Upload(data.vertices);
+    m_ResidentBytes += chunk.mesh.GpuBytes();
+    ++m_ChunksBuilt;
+    chunk.minY = data.minY;
+    chunk.maxY = data.maxY;
+    chunk.revision = revision;
+    chunk.lastUsedFrame = m_Frame;
+}
+
+void TerrainQuadtree::evictOverBudget() {
+    if (m_ResidentBytes <= m_MemoryBudget) return;
+    // Least recently used first. Chunks touched this frame (drawn, or ancestors of drawn
+    // chunks) are never released, so the budget can be exceeded while the view needs them.
+    std::vector<std::pair<unsigned, TerrainChunkKey>> lru;
+    for (const auto& kv : m_Chunks) {
+        if (kv.second.lastUsedFrame != m_Frame) lru.push_back({ kv.second.lastUsedFrame, kv.first });
+    }
+    std::sort(lru.begin(), lru.end());
+    for (const auto& entry : lru) {
+        if (m_ResidentBytes <= m_MemoryBudget) break;
+        auto it = m_Chunks.find(entry.second);
+        m_ResidentBytes -= it->second.mesh.GpuBytes();
+        it->second.mesh.Release();
+        m_Chunks.erase(it);
+        ++m_ChunksEvicted;
+    }
+}
+
+TerrainResidencyStats TerrainQuadtree::Stats() const {
+    TerrainResidencyStats stats;
+    stats.residentChunks = m_Chunks.size();
+    stats.residentBytes = m_ResidentBytes;
+    stats.budgetBytes = m_MemoryBudget;
+    stats.drawnChunks = m_DrawList.size();
+    stats.culledChunks = m_CulledChunks;
+    stats.pendingBuilds = m_InFlight.size();
+    stats.ringTiles = m_RingTiles;
+    stats.residentTiles = m_ResidentTiles;
+    stats.chunksBuilt = m_ChunksBuilt;
+    stats.chunksEvicted = m_ChunksEvicted;
+    stats.compactVertices = m_Compact;
+    stats.bytesPerVertex = m_Compact ? sizeof(TerrainCompactVertex) : sizeof(TerrainVertex);
+    return stats;
+}
+
+void TerrainQuadtree::Clear() {
+    // Builds in flight finish into the old queue, which goes away with the last of them
+    m_Queue = std::make_shared<BuildQueue>();
+    m_InFlight.clear();
+    for (auto& kv : m_Chunks) kv.second.mesh.Release();
+    m_Chunks.clear();
+    m_ResidentBytes = 0;
+    m_RingTiles = 0;
+    m_ResidentTiles = 0;
+    m_DrawList.clear();
+    m_Requests.clear();
+    m_Indices.Release();
+}
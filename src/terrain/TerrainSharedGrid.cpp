@@ -0,0 +1,44 @@
+#include "../../include/terrain/TerrainSharedGrid.h"
+#include <algorithm>
+
+void TerrainSharedGrid::Clear() {
+    m_Bands.clear();
+    m_Bands.shrink_to_fit();
+    m_Rows.clear();
+    m_Rows.shrink_to_fit();
+    m_Width = 0;
+    m_Height = 0;
+}
+
+void TerrainSharedGrid::Reset(int width, int height) {
+    Clear();
+    if (width <= 0 || height <= 0) return;
+    m_Width = width;
+    m_Height = height;
+    const int bands = (height + BAND_ROWS - 1) >> BAND_SHIFT;
+    m_Bands.reserve((size_t)bands);
+    m_Rows.reserve((size_t)height);
+    for (int b = 0; b < bands; ++b) {
+        // The last band only holds the rows that remain
+        int rows = std::min(BAND_ROWS, height - (b << BAND_SHIFT));
+        m_Bands.push_back(std::make_shared<std::vector<float>>((size_t)rows * width, 0.0f));
+        for (int r = 0; r < rows; ++r) m_Rows.push_back(m_Bands.back()->data() + (size_t)r * width);
+    }
+}
+
+float* TerrainSharedGrid::MutableRow(int j) {
+    const int b = j >> BAND_SHIFT;
+    std::shared_ptr<std::vector<float>>& band = m_Bands[(size_t)b];
+    // Only the writing thread copies grids, so no other copy can appear while this runs
+    if (band.use_count() > 1) {
+        band = std::make_shared<std::vector<float>>(*band);
+        int first = b << BAND_SHIFT;
+        int rows = std::min(BAND_ROWS, m_Height - first);
+        for (int r = 0; r < rows; ++r) m_Rows[(size_t)(first + r)] = band->data() + (size_t)r * m_Width;
+    }
+    return m_Rows[(size_t)j];
+}
+
+void TerrainSharedGrid::CopyTo(float* out) const {
+    for (int j = 0; j < m_Height; ++j) std::copy(Row(j), Row(j) + m_Width, out + (size_t)j * m_Width);
+}